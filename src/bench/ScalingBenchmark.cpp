@@ -0,0 +1,217 @@
+// Headless thread-scaling benchmark for the physics step.
+// Runs the same fixed scene through PhysicsEngine::update at 1, 2, 4, ... N
+// threads and reports the average step time for each thread count, for
+// every broadphase (or only the one given with --broadphase). The other
+// simulation options (--reorder, --cell-order, --sleep, --solver,
+// --solver-iterations) apply to every run. With --deterministic=on each run
+// also hashes the final state and reports whether it matches the
+// single-threaded run bitwise.
+//
+// Usage: BallBouncingBench [ballCount=100000] [steps=200] [--broadphase=...]
+//                          [--reorder=...] [--cell-order=...] [--sleep=...]
+//                          [--solver=...] [--solver-iterations=...]
+//                          [--deterministic=...]
+
+#define SDL_MAIN_HANDLED
+#include "../core/Config.h"
+#include "../core/JobSystem.h"
+#include "../core/SimulationOptions.h"
+#include "../entities/BallStore.h"
+#include "../entities/Container.h"
+#include "../math/MathUtils.h"
+#include "../math/StateHash.h"
+#include "../physics/PhysicsEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr float BENCH_BALL_RADIUS = 2.0f;
+    constexpr float BENCH_SPACING = 2.5f * BENCH_BALL_RADIUS;  // Lattice spacing (no initial overlap)
+    constexpr int WARMUP_STEPS = 10;
+    constexpr unsigned SCENE_SEED = 12345;
+    constexpr unsigned MIN_DETERMINISM_THREADS = 4;  // Thread counts 1, 2, 4 at least
+
+    // Closed container (no gap) sized so the lattice holds ballCount balls
+    float sceneContainerRadius(size_t ballCount) {
+        float area = static_cast<float>(ballCount) * BENCH_SPACING * BENCH_SPACING;
+        return std::sqrt(area / MathUtils::PI) * 1.1f + 4.0f * BENCH_SPACING;
+    }
+
+    // Lattice balls in shuffled storage order, like a population after a
+    // long run of culling and respawning
+    BallStore buildScene(size_t ballCount, const Container& container) {
+        std::srand(SCENE_SEED);
+
+        std::vector<Ball> lattice;
+        lattice.reserve(ballCount);
+
+        Vector2D center = container.getCenter();
+        float maxDistance = container.getRadius() - 2.0f * BENCH_BALL_RADIUS;
+        int halfSpan = static_cast<int>(maxDistance / BENCH_SPACING);
+
+        for (int gy = -halfSpan; gy <= halfSpan && lattice.size() < ballCount; ++gy) {
+            for (int gx = -halfSpan; gx <= halfSpan && lattice.size() < ballCount; ++gx) {
+                Vector2D offset(gx * BENCH_SPACING, gy * BENCH_SPACING);
+                if (offset.magnitude() > maxDistance) {
+                    continue;
+                }
+
+                float angle = MathUtils::randomRange(0.0f, MathUtils::TWO_PI);
+                float speed = MathUtils::randomRange(Config::BALL_MIN_VELOCITY, Config::BALL_MAX_VELOCITY);
+                SDL_Color color{255, 255, 255, 255};
+                lattice.push_back(Ball(center + offset, Vector2D::fromAngle(angle, speed), BENCH_BALL_RADIUS, color));
+            }
+        }
+
+        for (size_t i = lattice.size(); i > 1; --i) {
+            std::swap(lattice[i - 1], lattice[std::rand() % i]);
+        }
+
+        BallStore balls;
+        balls.reserve(lattice.size());
+        for (const Ball& ball : lattice) {
+            balls.push(ball);
+        }
+        return balls;
+    }
+
+    const char* broadphaseName(BroadphaseType type) {
+        switch (type) {
+            case BroadphaseType::SweepAndPrune: return "sap";
+            case BroadphaseType::AabbTree: return "tree";
+            case BroadphaseType::HierarchicalGrid: return "hgrid";
+            case BroadphaseType::SpatialHash: return "hash";
+            case BroadphaseType::NeighborList: return "verlet";
+            case BroadphaseType::IncrementalGrid: return "igrid";
+            case BroadphaseType::UniformGrid:
+            default: return "grid";
+        }
+    }
+
+    double runScene(JobSystem& jobs, BroadphaseType broadphase, const SimulationOptions& options,
+                    const BallStore& scene, const Container& sceneContainer, float worldSize, int steps,
+                    uint64_t& stateHash) {
+        PhysicsEngine physics(Config::GRAVITY, worldSize, worldSize);
+        physics.setJobSystem(&jobs);
+        physics.setBroadphase(broadphase);
+        physics.setReorderInterval(options.reorderInterval);
+        physics.setMortonCellOrder(options.mortonCells);
+        physics.setSleepEnabled(options.sleep);
+        physics.setSolver(options.solver);
+        physics.setSolverIterations(options.solverIterations);
+        physics.setIntegrator(options.integrator);
+        physics.setContinuousCollision(options.continuousCollision);
+        physics.setMultiRateEnabled(options.multiRate);
+        physics.setEventDriven(options.eventDriven);
+        physics.setDeterministic(options.deterministic);
+
+        BallStore balls = scene;
+        Container container = sceneContainer;
+
+        for (int s = 0; s < WARMUP_STEPS; ++s) {
+            container.update(Config::FIXED_TIMESTEP);
+            physics.update(balls, container, Config::FIXED_TIMESTEP, Config::RESTITUTION);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) {
+            container.update(Config::FIXED_TIMESTEP);
+            physics.update(balls, container, Config::FIXED_TIMESTEP, Config::RESTITUTION);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        stateHash = balls.hashState(StateHash::SEED);
+        return std::chrono::duration<double, std::milli>(end - start).count() / steps;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    SimulationOptions options;
+    if (!SimulationOptionsParser::parse(argc, argv, options)) {
+        return 1;
+    }
+
+    // Positional arguments: ball count, step count
+    std::vector<const char*> positional;
+    bool broadphaseGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && argv[i][1] == '-') {
+            broadphaseGiven = broadphaseGiven || std::string(argv[i]).compare(0, 13, "--broadphase=") == 0;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    size_t ballCount = positional.size() > 0 ? std::strtoul(positional[0], nullptr, 10) : 100000;
+    int steps = positional.size() > 1 ? std::atoi(positional[1]) : 200;
+
+    std::vector<BroadphaseType> broadphases;
+    if (broadphaseGiven) {
+        broadphases.push_back(options.broadphase);
+    } else {
+        broadphases = {BroadphaseType::UniformGrid, BroadphaseType::SweepAndPrune,
+                       BroadphaseType::AabbTree, BroadphaseType::HierarchicalGrid,
+                       BroadphaseType::SpatialHash, BroadphaseType::NeighborList,
+                       BroadphaseType::IncrementalGrid};
+    }
+
+    float containerRadius = sceneContainerRadius(ballCount);
+    float worldSize = 2.0f * containerRadius + 8.0f * BENCH_SPACING;
+    Container container(Vector2D(worldSize / 2.0f, worldSize / 2.0f), containerRadius, 0.0f);
+    BallStore scene = buildScene(ballCount, container);
+
+    // The determinism check needs several thread counts even on a small
+    // host; oversubscribing only slows those runs down
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (options.deterministic) {
+        maxThreads = std::max(maxThreads, MIN_DETERMINISM_THREADS);
+    }
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::printf("Scene: %zu balls, container radius %.0fpx, %d steps per run\n",
+                scene.size(), containerRadius, steps);
+    if (options.deterministic) {
+        std::printf("%10s %8s %12s %10s %18s\n", "broadphase", "threads", "ms/step", "speedup", "final state");
+    } else {
+        std::printf("%10s %8s %12s %10s\n", "broadphase", "threads", "ms/step", "speedup");
+    }
+
+    JobSystem jobs(1, Config::PIN_PHYSICS_THREADS);
+    bool reproduced = true;
+    for (BroadphaseType broadphase : broadphases) {
+        double baseline = 0.0;
+        uint64_t referenceHash = 0;
+        for (unsigned threads : threadCounts) {
+            jobs.setThreadCount(threads);
+            uint64_t stateHash = 0;
+            double msPerStep = runScene(jobs, broadphase, options, scene, container, worldSize, steps, stateHash);
+            if (threads == 1) {
+                baseline = msPerStep;
+                referenceHash = stateHash;
+            }
+            std::printf("%10s %8u %12.3f %9.2fx", broadphaseName(broadphase), threads, msPerStep, baseline / msPerStep);
+            if (options.deterministic) {
+                bool match = stateHash == referenceHash;
+                reproduced = reproduced && match;
+                std::printf(" %016" PRIx64 "%s", stateHash, match ? "" : " MISMATCH");
+            }
+            std::printf("\n");
+        }
+    }
+
+    if (options.deterministic) {
+        std::printf(reproduced ? "Every thread count reproduced the single-threaded state\n"
+                               : "Some thread counts diverged from the single-threaded state\n");
+    }
+    return reproduced ? 0 : 1;
+}
@@ -3,8 +3,9 @@
 #include "../math/MathUtils.h"
 #include <iostream>
 
-Application::Application()
-    : renderer(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT, Config::WINDOW_TITLE)
+Application::Application(const SimulationOptions& options)
+    : options(options)
+    , renderer(Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT, Config::WINDOW_TITLE)
     , bouncinessSlider(Config::SLIDER_X, Config::SLIDER_Y, Config::SLIDER_WIDTH, Config::SLIDER_HEIGHT, 0.95f, 1.05f, Config::RESTITUTION)
     , ballSizeSlider(Config::SIZE_SLIDER_X, Config::SIZE_SLIDER_Y, Config::SIZE_SLIDER_WIDTH, Config::SIZE_SLIDER_HEIGHT, 5.0f, 25.0f, Config::BALL_RADIUS)
     , holeSizeSlider(Config::HOLE_SLIDER_X, Config::HOLE_SLIDER_Y, Config::HOLE_SLIDER_WIDTH, Config::HOLE_SLIDER_HEIGHT, 0.0f, 180.0f, Config::CONTAINER_GAP_PERCENT * 360.0f)
@@ -55,6 +56,25 @@ bool Application::initialize() {
     }
 
     // Initialize game state
+    gameState.getPhysics().setBroadphase(options.broadphase);
+    gameState.getPhysics().setReorderInterval(options.reorderInterval);
+    gameState.getPhysics().setMortonCellOrder(options.mortonCells);
+    gameState.getPhysics().setSleepEnabled(options.sleep);
+    gameState.getPhysics().setSolver(options.solver);
+    gameState.getPhysics().setSolverIterations(options.solverIterations);
+    gameState.getPhysics().setIntegrator(options.integrator);
+    gameState.getPhysics().setContinuousCollision(options.continuousCollision);
+    gameState.getPhysics().setMultiRateEnabled(options.multiRate);
+    gameState.getPhysics().setEventDriven(options.eventDriven);
+    gameState.setAdaptiveSubsteps(options.adaptiveSubsteps);
+    gameState.getBallManager().setBallisticEnabled(options.ballistic);
+    gameState.setDeterministic(options.deterministic);
+    if (options.traceMode != TraceMode::Off) {
+        if (!trace.open(options.traceMode, options.tracePath)) {
+            return false;
+        }
+        gameState.setStateTrace(&trace);
+    }
     gameState.initialize();
 
     running = true;
@@ -76,12 +96,23 @@ void Application::run() {
         // Handle events
         handleEvents();
 
-        // Fixed timestep updates
-        int steps = 0;
-        while (accumulator >= Config::FIXED_TIMESTEP && steps < Config::MAX_PHYSICS_STEPS) {
-            update(Config::FIXED_TIMESTEP);
-            accumulator -= Config::FIXED_TIMESTEP;
-            steps++;
+        // Deterministic runs take the same fixed steps whatever the frame rate
+        if (options.adaptiveSubsteps && !options.deterministic) {
+            // Once a fixed step's worth of time has gathered, hand all of it
+            // (up to the same cap) to the game state, which substeps it
+            if (accumulator >= Config::FIXED_TIMESTEP) {
+                float maxFrameTime = Config::MAX_PHYSICS_STEPS * Config::FIXED_TIMESTEP;
+                update(accumulator < maxFrameTime ? accumulator : maxFrameTime);
+                accumulator = 0.0f;
+            }
+        } else {
+            // Fixed timestep updates
+            int steps = 0;
+            while (accumulator >= Config::FIXED_TIMESTEP && steps < Config::MAX_PHYSICS_STEPS) {
+                update(Config::FIXED_TIMESTEP);
+                accumulator -= Config::FIXED_TIMESTEP;
+                steps++;
+            }
         }
 
         // Render
@@ -90,6 +121,7 @@ void Application::run() {
 }
 
 void Application::cleanup() {
+    trace.finish();
     circleRenderer.cleanup();
     textRenderer.cleanup();
     renderer.cleanup();
@@ -202,16 +234,21 @@ void Application::renderContainer() {
 }
 
 void Application::renderBalls() {
-    const std::vector<Ball>& balls = gameState.getBallManager().getBalls();
+    const BallStore& balls = gameState.getBallManager().getBalls();
 
-    for (const Ball& ball : balls) {
+    for (size_t i = 0; i < balls.size(); ++i) {
         circleRenderer.drawFilledCircleFast(
             renderer.getSDLRenderer(),
-            ball.position,
-            ball.radius,
-            ball.color
+            Vector2D(balls.x[i], balls.y[i]),
+            balls.radius[i],
+            balls.color[i]
         );
     }
+
+    // Escaped balls are only evaluated here, at their current time
+    gameState.getBallManager().getBallistic().forEach([&](float x, float y, float radius, const SDL_Color& color) {
+        circleRenderer.drawFilledCircleFast(renderer.getSDLRenderer(), Vector2D(x, y), radius, color);
+    });
 }
 
 void Application::renderUI() {
@@ -267,6 +304,19 @@ void Application::renderUI() {
         Config::PENDING_RESPAWN_Y
     );
 
+    // Render substeps of the last update (adaptive substepping only)
+    if (gameState.isAdaptiveSubsteps()) {
+        char substepLabel[64];
+        snprintf(substepLabel, sizeof(substepLabel), "Substeps: %d", gameState.getSubstepCount());
+        textRenderer.renderText(
+            renderer.getSDLRenderer(),
+            substepLabel,
+            Config::SUBSTEP_DISPLAY_X,
+            Config::SUBSTEP_DISPLAY_Y,
+            Config::TEXT_COLOR
+        );
+    }
+
     // Render bounciness slider
     bouncinessSlider.render(renderer.getSDLRenderer(), "Bounciness");
 
@@ -360,8 +410,7 @@ void Application::renderUI() {
 
 void Application::resetSimulation() {
     // Clear all balls and reset to initial state
-    gameState.getBallManager().getBalls().clear();
-    gameState.initialize();
+    gameState.reset();
 
     // Reset timer
     time = Time();
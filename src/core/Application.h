@@ -7,10 +7,11 @@
 #include "../ui/Slider.h"
 #include "../ui/Button.h"
 #include "Time.h"
+#include "SimulationOptions.h"
 
 class Application {
 public:
-    Application();
+    explicit Application(const SimulationOptions& options = SimulationOptions());
     ~Application();
 
     bool initialize();
@@ -19,10 +20,12 @@ public:
 
 private:
     // Core systems
+    SimulationOptions options;
     Renderer renderer;
     GameState gameState;
     Time time;
     CircleRenderer circleRenderer;
+    StateTrace trace;
     TextRenderer textRenderer;
 
     // UI elements
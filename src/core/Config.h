@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <cstddef>
 
 namespace Config {
     // Window settings
@@ -28,10 +29,68 @@ namespace Config {
     constexpr float GRAVITY = 9.8f * 100.0f;  // 980 px/s² (9.8 m/s² scaled for pixels)
     constexpr float RESTITUTION = 1.0f;  // 100% bounce (perfectly elastic)
 
+    // Broadphase grid tuning
+    constexpr float GRID_CELL_MARGIN = 0.1f;        // Cell size = largest ball diameter * (1 + margin)
+    constexpr float GRID_CELL_SHRINK_RATIO = 0.5f;  // Re-tune down once the needed size falls below this fraction
+    constexpr float NEIGHBOR_SKIN_RATIO = 0.5f;     // Verlet list skin as a fraction of the largest radius
+    constexpr int HGRID_MAX_LEVELS = 16;            // Hierarchical grid levels (cell sizes base .. base * 2^15)
+    constexpr float AABB_TREE_FAT_MARGIN = 0.25f;   // Tree leaf boxes extend this fraction of the radius past the ball
+
+    // Sleep settings (resting balls stop being simulated until disturbed)
+    constexpr float SLEEP_SPEED = 4.0f;            // px/s net drift below which a ball counts as resting
+    constexpr int SLEEP_STEPS = 30;                // Steps a ball must rest before it may sleep
+    constexpr int SLEEP_CHECK_INTERVAL = 8;        // Steps between island searches
+    constexpr float SLEEP_WAKE_SPEED = 100.0f;     // px/s approach speed at which a hit wakes a sleeping island
+    constexpr float SLEEP_CONTACT_SLOP = 0.05f;    // Balls within (1 + slop) * (r1 + r2) belong to one island
+    constexpr float SLEEP_GAP_MARGIN = 10.0f;      // Degrees; wall balls this close to the gap stay awake
+
+    // Sequential-impulse solver settings
+    constexpr int SOLVER_ITERATIONS = 8;                   // Velocity iterations per step (default)
+    constexpr int SOLVER_POSITION_ITERATIONS = 3;          // Split-impulse iterations per step
+    constexpr float SOLVER_POSITION_BETA = 0.2f;           // Fraction of the overlap removed per step
+    constexpr float SOLVER_SLOP_RATIO = 0.02f;             // Overlap left alone, as a fraction of the radius
+    constexpr float SOLVER_RESTITUTION_THRESHOLD = 100.0f; // px/s; slower impacts do not bounce (1 m/s)
+
+    // Position-based (XPBD) solver settings; iterations shared with the impulse solver
+    constexpr float XPBD_COMPLIANCE = 0.0f;       // Contact compliance (inverse stiffness); 0 = rigid
+    constexpr float XPBD_CONTACT_MARGIN = 0.1f;   // Gather pairs within (1 + margin) * (r1 + r2) of the predicted positions
+
+    // Continuous collision settings
+    constexpr float CCD_DISPLACEMENT_RATIO = 0.5f;  // Sweep balls that move more than this fraction of their radius per step
+    constexpr int CCD_MAX_HITS = 4;                 // Wall hits per ball and step before it stops at the contact
+
+    // Event-driven mode settings (gravity 0 only)
+    constexpr float EVENT_MAX_PACKING = 0.2f;        // Fraction of the container area balls may cover
+    constexpr int EVENT_MAX_PER_STEP = 20000;        // Contacts resolved per step before falling back to a rebuild
+    constexpr float EVENT_EDGE_TOLERANCE = 1e-3f;    // Gap edge contact distance, as a fraction of the ball radius
+    constexpr int EVENT_EDGE_MAX_STEPS = 64;         // Gap edge search steps per prediction before a recheck
+
+    // Deterministic mode settings
+    constexpr unsigned int DETERMINISTIC_SEED = 12345u;  // Spawn random sequence of deterministic runs
+
+    // Ballistic fast path settings
+    constexpr float BALLISTIC_CLEARANCE = 15.0f;     // Distance beyond the wall before an escaped ball stops being simulated
+
+    // Multi-rate stepping settings
+    constexpr int MULTIRATE_MAX_LEVEL = 3;        // Coarsest balls step once every 2^3 steps
+    constexpr int MULTIRATE_REGION_CELLS = 2;     // Region side in broadphase grid cells
+    constexpr int MULTIRATE_SEARCH_RINGS = 3;     // Rings of regions searched for the nearest other ball
+
     // Simulation settings
     constexpr float FIXED_TIMESTEP = 1.0f / 120.0f;  // 120Hz physics updates
     constexpr int MAX_PHYSICS_STEPS = 5;  // Prevent spiral of death
 
+    // Adaptive substepping settings
+    constexpr float SUBSTEP_CFL = 1.0f;                   // Fraction of the smallest radius the fastest ball may move per substep
+    constexpr float SUBSTEP_MAX_TIMESTEP = 1.0f / 60.0f;  // Longest substep, taken by calm scenes
+    constexpr int SUBSTEP_MAX_COUNT = 16;                 // Most substeps per update
+
+    // Threading settings
+    constexpr unsigned PHYSICS_THREAD_COUNT = 0;  // 0 = one thread per hardware thread
+    constexpr bool PIN_PHYSICS_THREADS = false;   // Pin the calling and worker threads to cores (Linux only)
+    constexpr size_t PARALLEL_GRAIN_SIZE = 2048;  // Minimum balls per parallel chunk
+    constexpr size_t PARALLEL_CELL_GRAIN_SIZE = 32;  // Minimum grid cells per narrowphase chunk
+
     // UI settings
     constexpr int FPS_DISPLAY_X = 10;
     constexpr int FPS_DISPLAY_Y = 10;
@@ -41,6 +100,8 @@ namespace Config {
     constexpr int PENDING_RESPAWN_Y = 180;
     constexpr int TIMER_DISPLAY_X = 10;
     constexpr int TIMER_DISPLAY_Y = 70;
+    constexpr int SUBSTEP_DISPLAY_X = 10;
+    constexpr int SUBSTEP_DISPLAY_Y = 210;
     constexpr int UI_FONT_SIZE = 20;
 
     // Slider settings (all shifted down by 50px)
@@ -0,0 +1,205 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct JobSystem::SavedAffinity {
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+#endif
+};
+
+JobSystem::JobSystem(unsigned threadCount, bool pinThreads)
+    : threadCount(0)
+    , pinThreads(pinThreads)
+    , queuedTasks(0)
+    , unfinishedTasks(0)
+    , stopping(false)
+{
+    setThreadCount(threadCount);
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::setThreadCount(unsigned count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    stop();
+    threadCount = count;
+    start();
+}
+
+void JobSystem::start() {
+    stopping = false;
+
+    queues.clear();
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    // Queue 0 is served by the calling thread (the pool's owner, which
+    // starts it), so it is pinned to CPU 0 like worker i is to CPU i
+    if (pinThreads) {
+        pinOwner();
+    }
+
+    // The rest of the queues get a worker each
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    unpinOwner();
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    if (pinThreads) {
+        pinCurrentThread(index);
+    }
+
+    while (true) {
+        if (runOneTask(index)) {
+            continue;
+        }
+
+        // Spin briefly: parallelFor calls come in bursts within a step
+        bool workArrived = false;
+        for (int spin = 0; spin < SPIN_COUNT; ++spin) {
+            if (queuedTasks.load(std::memory_order_acquire) > 0) {
+                workArrived = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        if (workArrived) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this]() {
+            return stopping || queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void JobSystem::dispatch(InvokeFn invoke, const void* context, size_t count, size_t grainSize) {
+    // Chunks of at least grainSize, but enough of them for stealing to balance
+    size_t maxChunks = static_cast<size_t>(threadCount) * CHUNKS_PER_THREAD;
+    size_t chunkCount = std::min((count + grainSize - 1) / grainSize, maxChunks);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    unfinishedTasks.store(chunkCount, std::memory_order_relaxed);
+
+    // Deal chunks round-robin so every thread starts with local work
+    for (size_t c = 0; c < chunkCount; ++c) {
+        Task task{invoke, context, c * chunkSize, std::min(count, (c + 1) * chunkSize)};
+        WorkQueue& queue = *queues[c % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    queuedTasks.fetch_add(chunkCount, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_all();
+
+    // The calling thread works until every chunk is done
+    while (unfinishedTasks.load(std::memory_order_acquire) > 0) {
+        if (!runOneTask(0)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::runOneTask(unsigned index) {
+    Task task;
+    if (!popLocal(index, task) && !steal(index, task)) {
+        return false;
+    }
+
+    queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    task.invoke(task.context, task.begin, task.end);
+    unfinishedTasks.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool JobSystem::popLocal(unsigned index, Task& out) {
+    WorkQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    out = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(unsigned thief, Task& out) {
+    const size_t queueCount = queues.size();
+    for (size_t offset = 1; offset < queueCount; ++offset) {
+        WorkQueue& victim = *queues[(thief + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::pinCurrentThread(unsigned cpu) {
+#if defined(__linux__)
+    unsigned cpuCount = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu % cpuCount, &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#else
+    (void)cpu;  // Pinning is only implemented on Linux
+#endif
+}
+
+void JobSystem::pinOwner() {
+#if defined(__linux__)
+    auto saved = std::make_unique<SavedAffinity>();
+    if (pthread_getaffinity_np(pthread_self(), sizeof(saved->cpuSet), &saved->cpuSet) == 0) {
+        ownerAffinity = std::move(saved);
+    }
+#endif
+    pinCurrentThread(0);
+}
+
+void JobSystem::unpinOwner() {
+    if (!ownerAffinity) {
+        return;
+    }
+#if defined(__linux__)
+    pthread_setaffinity_np(pthread_self(), sizeof(ownerAffinity->cpuSet), &ownerAffinity->cpuSet);
+#endif
+    ownerAffinity.reset();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Small work-stealing thread pool for the simulation step.
+// Every thread owns a deque: it pops its own chunks from the back and steals
+// from the front of the other deques when it runs dry. The thread calling
+// parallelFor() works too, so a pool of N threads runs N - 1 workers.
+// parallelFor() must only be called from the thread that owns the pool.
+class JobSystem {
+public:
+    // threadCount == 0 uses every hardware thread. With pinThreads the
+    // owning thread is pinned to CPU 0 while the pool runs (its previous
+    // affinity comes back when the pool stops or restarts) and worker i to
+    // CPU i. Construct, restart and destroy the pool on the owning thread.
+    explicit JobSystem(unsigned threadCount = 0, bool pinThreads = false);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Restart the pool with a different number of threads
+    void setThreadCount(unsigned threadCount);
+    unsigned getThreadCount() const { return threadCount; }
+
+    // Call fn(begin, end) over [0, count) in chunks of at least grainSize
+    // indices and block until every chunk has finished
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grainSize, Fn&& fn);
+
+private:
+    using InvokeFn = void (*)(const void* context, size_t begin, size_t end);
+
+    struct Task {
+        InvokeFn invoke;
+        const void* context;
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct SavedAffinity;  // Platform affinity mask of the owning thread
+
+    static constexpr size_t CHUNKS_PER_THREAD = 4;  // Slack for stealing to balance load
+    static constexpr int SPIN_COUNT = 2000;         // Polls before a worker sleeps
+
+    unsigned threadCount;
+    bool pinThreads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;  // [0] belongs to the calling thread
+    std::vector<std::thread> workers;
+    std::unique_ptr<SavedAffinity> ownerAffinity;  // Set while the owner is pinned
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<size_t> queuedTasks;      // Tasks sitting in any deque
+    std::atomic<size_t> unfinishedTasks;  // Tasks of the running parallelFor
+    bool stopping;
+
+    void start();
+    void stop();
+    void workerLoop(unsigned index);
+
+    void dispatch(InvokeFn invoke, const void* context, size_t count, size_t grainSize);
+    bool runOneTask(unsigned index);
+    bool popLocal(unsigned index, Task& out);
+    bool steal(unsigned thief, Task& out);
+
+    static void pinCurrentThread(unsigned cpu);
+    void pinOwner();
+    void unpinOwner();
+};
+
+template <typename Fn>
+void JobSystem::parallelFor(size_t count, size_t grainSize, Fn&& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (grainSize == 0) {
+        grainSize = 1;
+    }
+
+    // Not worth splitting: run inline on the calling thread
+    if (workers.empty() || count <= grainSize) {
+        fn(static_cast<size_t>(0), count);
+        return;
+    }
+
+    using FnType = std::remove_reference_t<Fn>;
+    InvokeFn invoke = [](const void* context, size_t begin, size_t end) {
+        (*static_cast<FnType*>(const_cast<void*>(context)))(begin, end);
+    };
+    dispatch(invoke, &fn, count, grainSize);
+}
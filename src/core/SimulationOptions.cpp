@@ -0,0 +1,197 @@
+#include "SimulationOptions.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace SimulationOptionsParser {
+
+namespace {
+    bool parseBroadphase(const std::string& value, BroadphaseType& out) {
+        if (value == "grid") {
+            out = BroadphaseType::UniformGrid;
+        } else if (value == "sap") {
+            out = BroadphaseType::SweepAndPrune;
+        } else if (value == "tree") {
+            out = BroadphaseType::AabbTree;
+        } else if (value == "hgrid") {
+            out = BroadphaseType::HierarchicalGrid;
+        } else if (value == "hash") {
+            out = BroadphaseType::SpatialHash;
+        } else if (value == "verlet") {
+            out = BroadphaseType::NeighborList;
+        } else if (value == "igrid") {
+            out = BroadphaseType::IncrementalGrid;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseSolver(const std::string& value, SolverType& out) {
+        if (value == "pairwise") {
+            out = SolverType::Pairwise;
+        } else if (value == "impulse") {
+            out = SolverType::SequentialImpulse;
+        } else if (value == "xpbd") {
+            out = SolverType::PositionBased;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseIntegrator(const std::string& value, IntegratorType& out) {
+        if (value == "euler") {
+            out = IntegratorType::SemiImplicitEuler;
+        } else if (value == "verlet") {
+            out = IntegratorType::VelocityVerlet;
+        } else if (value == "position-verlet") {
+            out = IntegratorType::PositionVerlet;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseCellOrder(const std::string& value, bool& morton) {
+        if (value == "row") {
+            morton = false;
+        } else if (value == "morton") {
+            morton = true;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseSubsteps(const std::string& value, bool& adaptive) {
+        if (value == "fixed") {
+            adaptive = false;
+        } else if (value == "adaptive") {
+            adaptive = true;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseSwitch(const std::string& value, bool& out) {
+        if (value == "on") {
+            out = true;
+        } else if (value == "off") {
+            out = false;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseTrace(const std::string& value, TraceMode mode, SimulationOptions& options) {
+        if (value.empty()) {
+            return false;
+        }
+        options.traceMode = mode;
+        options.tracePath = value;
+        return true;
+    }
+
+    bool parseCount(const std::string& value, int& out) {
+        char* end = nullptr;
+        long parsed = std::strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || parsed < 0 || parsed > 1000000) {
+            return false;
+        }
+        out = static_cast<int>(parsed);
+        return true;
+    }
+}
+
+bool parse(int argc, char* argv[], SimulationOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            continue;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+        bool ok = false;
+        if (name == "broadphase") {
+            ok = parseBroadphase(value, options.broadphase);
+        } else if (name == "reorder") {
+            ok = parseCount(value, options.reorderInterval);
+        } else if (name == "cell-order") {
+            ok = parseCellOrder(value, options.mortonCells);
+        } else if (name == "sleep") {
+            ok = parseSwitch(value, options.sleep);
+        } else if (name == "solver") {
+            ok = parseSolver(value, options.solver);
+        } else if (name == "solver-iterations") {
+            ok = parseCount(value, options.solverIterations) && options.solverIterations > 0;
+        } else if (name == "integrator") {
+            ok = parseIntegrator(value, options.integrator);
+        } else if (name == "ccd") {
+            ok = parseSwitch(value, options.continuousCollision);
+        } else if (name == "substeps") {
+            ok = parseSubsteps(value, options.adaptiveSubsteps);
+        } else if (name == "events") {
+            ok = parseSwitch(value, options.eventDriven);
+        } else if (name == "ballistic") {
+            ok = parseSwitch(value, options.ballistic);
+        } else if (name == "deterministic") {
+            ok = parseSwitch(value, options.deterministic);
+        } else if (name == "trace-record") {
+            ok = parseTrace(value, TraceMode::Record, options);
+        } else if (name == "trace-verify") {
+            ok = parseTrace(value, TraceMode::Verify, options);
+        } else if (name == "multirate") {
+            ok = parseSwitch(value, options.multiRate);
+        }
+
+        if (!ok) {
+            std::cerr << "Invalid option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    // A trace only means something for a deterministic run
+    if (options.traceMode != TraceMode::Off) {
+        options.deterministic = true;
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --broadphase=TYPE        Broadphase: grid (uniform grid), sap (sort-and-sweep),\n"
+              << "                           tree (AABB tree), hgrid (hierarchical grid),\n"
+              << "                           hash (spatial hash), verlet (neighbor lists) or\n"
+              << "                           igrid (incremental grid)\n"
+              << "  --reorder=STEPS          Re-sort balls by grid cell every STEPS steps (0 = off)\n"
+              << "  --cell-order=row|morton  Grid cell layout and walk order\n"
+              << "  --sleep=on|off           Put resting contact islands to sleep\n"
+              << "  --solver=TYPE            Contact solver: pairwise (one pass, positional separation),\n"
+              << "                           impulse (sequential impulses, warm started) or\n"
+              << "                           xpbd (position-based projection)\n"
+              << "  --solver-iterations=N    Iterations of the impulse or xpbd solver per step\n"
+              << "  --integrator=TYPE        Pairwise solver integrator: euler (semi-implicit),\n"
+              << "                           verlet (velocity Verlet) or position-verlet\n"
+              << "  --ccd=on|off             Sweep fast balls against the container wall\n"
+              << "  --substeps=fixed|adaptive\n"
+              << "                           Fixed 120 Hz steps, or substeps per frame chosen\n"
+              << "                           from the fastest ball\n"
+              << "  --multirate=on|off       Step isolated balls every 2, 4 or 8 steps\n"
+              << "  --events=on|off          Event-driven exact collisions while gravity is 0\n"
+              << "                           and the container is sparse\n"
+              << "  --ballistic=on|off       Stop simulating balls that escaped the container\n"
+              << "                           and fly them out on their parabola\n"
+              << "  --deterministic=on|off   Fixed seed, thread-count independent contact order\n"
+              << "                           and fixed steps, with a state hash every step\n"
+              << "  --trace-record=FILE      Deterministic run writing every step's hash to FILE\n"
+              << "  --trace-verify=FILE      Deterministic run checking every step against FILE\n";
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../physics/Broadphase.h"
+#include "../physics/Solver.h"
+#include "../physics/Integrator.h"
+#include "../game/StateTrace.h"
+#include "Config.h"
+#include <string>
+
+// Per-run simulation settings chosen on the command line at startup
+struct SimulationOptions {
+    BroadphaseType broadphase = BroadphaseType::UniformGrid;
+    int reorderInterval = 0;   // Steps between re-sorting balls by grid cell (0 = off)
+    bool mortonCells = false;  // Lay out and walk grid cells in Morton order
+    bool sleep = false;        // Put resting contact islands to sleep
+    SolverType solver = SolverType::Pairwise;
+    int solverIterations = Config::SOLVER_ITERATIONS;  // Impulse velocity / XPBD projection iterations
+    IntegratorType integrator = IntegratorType::SemiImplicitEuler;  // Pairwise solver only
+    bool continuousCollision = true;  // Sweep fast balls against the container wall
+    bool adaptiveSubsteps = false;    // Substep count per update from the fastest ball
+    bool multiRate = false;           // Step isolated balls less often than crowded ones
+    bool eventDriven = false;         // Exact event-driven collisions at gravity 0
+    bool ballistic = false;           // Fly escaped balls out analytically
+    bool deterministic = false;       // Fixed seed, thread-count independent contacts, per-step state hash
+    TraceMode traceMode = TraceMode::Off;  // Record or verify the state hashes (implies deterministic)
+    std::string tracePath;
+};
+
+namespace SimulationOptionsParser {
+    // Parse "--name=value" flags into options. Arguments that do not start
+    // with "--" are left for the caller. Prints usage and returns false on an
+    // unknown flag or value.
+    bool parse(int argc, char* argv[], SimulationOptions& options);
+
+    void printUsage(const char* program);
+}
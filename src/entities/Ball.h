@@ -32,6 +32,9 @@ public:
     float getRadius() const { return radius; }
     float getMass() const { return mass; }
 
+    // Number the next ball 0 again (deterministic runs)
+    static void resetIds() { nextId = 0; }
+
 private:
     static uint32_t nextId;
     void calculateMass();
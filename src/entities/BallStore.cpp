@@ -0,0 +1,200 @@
+#include "BallStore.h"
+#include "../math/StateHash.h"
+
+namespace {
+    template <typename T>
+    void permuteColumn(std::vector<T>& column, const std::vector<uint32_t>& order, std::vector<T>& scratch) {
+        scratch.resize(column.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            scratch[k] = column[order[k]];
+        }
+        column.swap(scratch);
+    }
+}
+
+BallStore::BallStore()
+    : layoutVersion(0)
+    , lastSurvivorCount(0)
+{
+}
+
+void BallStore::reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    vx.reserve(count);
+    vy.reserve(count);
+    radius.reserve(count);
+    invMass.reserve(count);
+    color.reserve(count);
+    id.reserve(count);
+    stepScale.reserve(count);
+    island.reserve(count);
+    restSteps.reserve(count);
+    restX.reserve(count);
+    restY.reserve(count);
+    rateLevel.reserve(count);
+}
+
+void BallStore::clear() {
+    resizeColumns(0);
+    lastRemap.clear();
+    lastSurvivorCount = 0;
+    ++layoutVersion;
+}
+
+void BallStore::push(const Ball& ball) {
+    push(ball.position.x, ball.position.y, ball.velocity.x, ball.velocity.y,
+         ball.radius, 1.0f / ball.mass, ball.color, ball.id);
+}
+
+void BallStore::push(float x, float y, float vx, float vy, float radius, float invMass,
+                     const SDL_Color& color, uint32_t id) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->vx.push_back(vx);
+    this->vy.push_back(vy);
+    this->radius.push_back(radius);
+    this->invMass.push_back(invMass);
+    this->color.push_back(color);
+    this->id.push_back(id);
+    stepScale.push_back(1.0f);
+    island.push_back(0);
+    restSteps.push_back(0);
+    restX.push_back(x);
+    restY.push_back(y);
+    rateLevel.push_back(0);
+}
+
+bool BallStore::isOffScreen(size_t index, float screenWidth, float screenHeight) const {
+    const float px = x[index];
+    const float py = y[index];
+    const float r = radius[index];
+
+    // Top / bottom edge
+    if (py - r < 0) return true;
+    if (py + r > screenHeight) return true;
+
+    // Left / right edge
+    if (px + r < 0) return true;
+    if (px - r > screenWidth) return true;
+
+    return false;
+}
+
+uint64_t BallStore::hashState(uint64_t hash) const {
+    hash = StateHash::add(hash, x);
+    hash = StateHash::add(hash, y);
+    hash = StateHash::add(hash, vx);
+    hash = StateHash::add(hash, vy);
+    hash = StateHash::add(hash, radius);
+    hash = StateHash::add(hash, invMass);
+    hash = StateHash::add(hash, color);
+    hash = StateHash::add(hash, id);
+    hash = StateHash::add(hash, stepScale);
+    hash = StateHash::add(hash, island);
+    hash = StateHash::add(hash, restSteps);
+    hash = StateHash::add(hash, restX);
+    hash = StateHash::add(hash, restY);
+    return StateHash::add(hash, rateLevel);
+}
+
+void BallStore::permute(const std::vector<uint32_t>& order) {
+    permuteColumn(x, order, floatScratch);
+    permuteColumn(y, order, floatScratch);
+    permuteColumn(vx, order, floatScratch);
+    permuteColumn(vy, order, floatScratch);
+    permuteColumn(radius, order, floatScratch);
+    permuteColumn(invMass, order, floatScratch);
+    permuteColumn(color, order, colorScratch);
+    permuteColumn(id, order, idScratch);
+    permuteColumn(stepScale, order, floatScratch);
+    permuteColumn(island, order, idScratch);
+    permuteColumn(restSteps, order, restScratch);
+    permuteColumn(restX, order, floatScratch);
+    permuteColumn(restY, order, floatScratch);
+    permuteColumn(rateLevel, order, levelScratch);
+
+    remapScratch.resize(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        remapScratch[order[k]] = static_cast<uint32_t>(k);
+    }
+    lastRemap.swap(remapScratch);
+    lastSurvivorCount = order.size();
+    ++layoutVersion;
+}
+
+bool BallStore::syncIndexList(std::vector<uint32_t>& indices, uint64_t& version, size_t& count) const {
+    if (version != layoutVersion) {
+        if (version + 1 != layoutVersion) {
+            // Missed a re-layout: start over from every row
+            indices.resize(size());
+            for (size_t i = 0; i < indices.size(); ++i) {
+                indices[i] = static_cast<uint32_t>(i);
+            }
+            version = layoutVersion;
+            count = size();
+            return false;
+        }
+
+        // Renumber survivors, drop removed rows
+        size_t write = 0;
+        for (uint32_t index : indices) {
+            uint32_t mapped = index < lastRemap.size() ? lastRemap[index] : REMOVED;
+            if (mapped != REMOVED) {
+                indices[write++] = mapped;
+            }
+        }
+        indices.resize(write);
+
+        // Rows appended before the re-layout that survived it
+        for (size_t old = count; old < lastRemap.size(); ++old) {
+            if (lastRemap[old] != REMOVED) {
+                indices.push_back(lastRemap[old]);
+            }
+        }
+
+        version = layoutVersion;
+        count = lastSurvivorCount;
+    }
+
+    // Rows appended since
+    for (size_t i = count; i < size(); ++i) {
+        indices.push_back(static_cast<uint32_t>(i));
+    }
+    count = size();
+    return true;
+}
+
+void BallStore::moveRow(size_t from, size_t to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    vx[to] = vx[from];
+    vy[to] = vy[from];
+    radius[to] = radius[from];
+    invMass[to] = invMass[from];
+    color[to] = color[from];
+    id[to] = id[from];
+    stepScale[to] = stepScale[from];
+    island[to] = island[from];
+    restSteps[to] = restSteps[from];
+    restX[to] = restX[from];
+    restY[to] = restY[from];
+    rateLevel[to] = rateLevel[from];
+}
+
+void BallStore::resizeColumns(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    vx.resize(count);
+    vy.resize(count);
+    radius.resize(count);
+    invMass.resize(count);
+    color.resize(count);
+    id.resize(count);
+    stepScale.resize(count);
+    island.resize(count);
+    restSteps.resize(count);
+    restX.resize(count);
+    restY.resize(count);
+    rateLevel.resize(count);
+}
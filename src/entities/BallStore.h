@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Ball.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays storage for the ball population.
+// Hot columns (position, velocity, radius, inverse mass) are contiguous so
+// the physics loops only stream the bytes they use; color and id live in
+// cold columns that only spawning and rendering touch.
+//
+// Row indices are stable until a re-layout (removal, permute or clear). Each
+// re-layout bumps the layout version and records an old -> new index
+// remap, so structures that keep ball indices across steps can follow it
+// instead of rebuilding. Appending never renumbers existing rows.
+class BallStore {
+public:
+    static constexpr uint32_t REMOVED = 0xFFFFFFFFu;  // Remap entry of a removed row
+
+    BallStore();
+
+    // Hot columns (physics)
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> radius;
+    std::vector<float> invMass;  // 1 / (π * r²)
+
+    // Cold columns (rendering / bookkeeping)
+    std::vector<SDL_Color> color;
+    std::vector<uint32_t> id;
+
+    // Sleep state (see PhysicsEngine::setSleepEnabled)
+    std::vector<float> stepScale;      // 1 = awake, 0 = asleep; integration advances by deltaTime * stepScale
+                                       // (multi-rate balls: 0 inside their block, the block length at its end)
+    std::vector<uint32_t> island;      // Island id of a sleeping ball, 0 = awake
+    std::vector<uint16_t> restSteps;   // Consecutive steps spent near the rest anchor
+    std::vector<float> restX;          // Rest anchor: position when the count started
+    std::vector<float> restY;
+
+    // Multi-rate state (see PhysicsEngine::setMultiRateEnabled)
+    std::vector<uint8_t> rateLevel;    // The ball steps once every 2^rateLevel steps
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void reserve(size_t count);
+    void clear();
+
+    // Append a ball, splitting it into columns
+    void push(const Ball& ball);
+
+    // Append a ball from its fields; unlike constructing a Ball, takes no id
+    void push(float x, float y, float vx, float vy, float radius, float invMass, const SDL_Color& color, uint32_t id);
+
+    // Bounds checking (same rule as Ball::isOffScreen)
+    bool isOffScreen(size_t index, float screenWidth, float screenHeight) const;
+
+    // Fold every column, row by row, into a StateHash fingerprint
+    uint64_t hashState(uint64_t hash) const;
+
+    // Remove every ball for which pred(index) is true, keeping the
+    // relative order of the survivors. Returns the number removed.
+    template <typename Predicate>
+    size_t removeIf(Predicate pred);
+
+    // Reorder the rows so that new row k is old row order[k]; order must be
+    // a permutation of every row. Counts as a re-layout. Ids move with their
+    // rows, so they stay stable.
+    void permute(const std::vector<uint32_t>& order);
+
+    // Layout tracking
+    uint64_t getLayoutVersion() const { return layoutVersion; }
+
+    // Bring a list of row indices captured at (version, count) up to date:
+    // removed rows are dropped, survivors renumbered and rows added since are
+    // appended. If more than one re-layout happened since the capture the
+    // list is reset to every row in index order and false is returned.
+    bool syncIndexList(std::vector<uint32_t>& indices, uint64_t& version, size_t& count) const;
+
+    // Old -> new index remap of the latest re-layout (REMOVED for dropped
+    // rows), for structures that map ball indices to something else
+    const std::vector<uint32_t>& getLastRemap() const { return lastRemap; }
+
+private:
+    uint64_t layoutVersion;
+    std::vector<uint32_t> lastRemap;  // Old index -> new index for the latest re-layout
+    size_t lastSurvivorCount;         // Rows kept by the latest re-layout
+    std::vector<uint32_t> remapScratch;
+
+    // Column scratch for permute (swapped with the columns, so reused)
+    std::vector<float> floatScratch;
+    std::vector<SDL_Color> colorScratch;
+    std::vector<uint32_t> idScratch;
+    std::vector<uint16_t> restScratch;
+    std::vector<uint8_t> levelScratch;
+
+    void moveRow(size_t from, size_t to);
+    void resizeColumns(size_t count);
+};
+
+template <typename Predicate>
+size_t BallStore::removeIf(Predicate pred) {
+    const size_t count = size();
+    remapScratch.resize(count);
+
+    size_t write = 0;
+    for (size_t read = 0; read < count; ++read) {
+        if (pred(read)) {
+            remapScratch[read] = REMOVED;
+            continue;
+        }
+        if (write != read) {
+            moveRow(read, write);
+        }
+        remapScratch[read] = static_cast<uint32_t>(write);
+        ++write;
+    }
+
+    // Only a real removal is a re-layout; otherwise keep the previous remap
+    if (write != count) {
+        resizeColumns(write);
+        lastRemap.swap(remapScratch);
+        lastSurvivorCount = write;
+        ++layoutVersion;
+    }
+    return count - write;
+}
@@ -0,0 +1,168 @@
+#include "BallisticSet.h"
+#include "../core/Config.h"
+#include "../math/StateHash.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+    // First t >= 0 at which a t² + b t + c drops below zero, given c >= 0
+    // (NEVER if it stays non-negative)
+    double firstNegative(double a, double b, double c) {
+        if (c < 0.0) {
+            return 0.0;
+        }
+        if (a == 0.0) {
+            return b < 0.0 ? -c / b : NEVER;
+        }
+
+        double discriminant = b * b - 4.0 * a * c;
+        if (discriminant <= 0.0) {
+            return NEVER;  // Opens upward and at most touches zero
+        }
+        double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+        double r1 = q / a;
+        double r2 = c / q;
+        if (r1 > r2) {
+            std::swap(r1, r2);
+        }
+
+        // c >= 0 puts t = 0 outside the negative region (a > 0: between the
+        // roots) or inside the non-negative one (a < 0: between the roots)
+        if (a > 0.0) {
+            return r1 >= 0.0 ? r1 : NEVER;
+        }
+        return r2;
+    }
+}
+
+BallisticSet::BallisticSet()
+    : clock(0.0)
+    , gravity(0.0f)
+    , wallCenter(0.0f, 0.0f)
+    , wallRadius(0.0f)
+    , screenWidth(0.0f)
+    , screenHeight(0.0f)
+{
+}
+
+void BallisticSet::beginStep(BallStore& balls, const Container& container, float gravity, float deltaTime) {
+    // The flights are only guaranteed clear of the wall they were captured for
+    if (gravity != this->gravity || container.getRadius() != wallRadius) {
+        float previousGravity = this->gravity;
+        this->gravity = gravity;
+        wallCenter = container.getCenter();
+        wallRadius = container.getRadius();
+        recheck(balls, previousGravity);
+    }
+    clock += deltaTime;
+}
+
+bool BallisticSet::isEscaping(float px, float py, float vx, float vy, float r) const {
+    float qx = px - wallCenter.x;
+    float qy = py - wallCenter.y;
+    float reach = wallRadius + r + Config::BALLISTIC_CLEARANCE;
+    if (qx * qx + qy * qy <= reach * reach) {
+        return false;
+    }
+
+    // With q(t) = q + v t + g t²/2 along y, d/dt |q|²/2 = q·v
+    // + (|v|² + qy g) t + 3/2 vy g t² + g²/2 t³: never negative if the
+    // first three coefficients are not (the distance grows for good)
+    return qx * vx + qy * vy > 0.0f
+        && vx * vx + vy * vy + qy * gravity >= 0.0f
+        && vy * gravity >= 0.0f;
+}
+
+bool BallisticSet::canCapture(const BallStore& balls, size_t index) const {
+    // A zero step scale means the position lags the clock (asleep, or
+    // inside a multi-rate block)
+    return balls.stepScale[index] > 0.0f
+        && isEscaping(balls.x[index], balls.y[index], balls.vx[index], balls.vy[index], balls.radius[index]);
+}
+
+void BallisticSet::capture(const BallStore& balls, size_t index, float screenWidth, float screenHeight) {
+    this->screenWidth = screenWidth;
+    this->screenHeight = screenHeight;
+
+    Flight flight;
+    flight.startTime = clock;
+    flight.x = balls.x[index];
+    flight.y = balls.y[index];
+    flight.vx = balls.vx[index];
+    flight.vy = balls.vy[index];
+    flight.radius = balls.radius[index];
+    flight.invMass = balls.invMass[index];
+    flight.color = balls.color[index];
+    flight.id = balls.id[index];
+    solveExitTime(flight);
+
+    flights.push_back(flight);
+    std::push_heap(flights.begin(), flights.end(), Later());
+}
+
+size_t BallisticSet::removeExited() {
+    size_t count = 0;
+    while (!flights.empty() && flights.front().exitTime <= clock) {
+        std::pop_heap(flights.begin(), flights.end(), Later());
+        flights.pop_back();
+        ++count;
+    }
+    return count;
+}
+
+uint64_t BallisticSet::hashState(uint64_t hash) const {
+    // Field by field: Flight has padding
+    hash = StateHash::add(hash, clock);
+    for (const Flight& flight : flights) {
+        hash = StateHash::add(hash, flight.exitTime);
+        hash = StateHash::add(hash, flight.startTime);
+        hash = StateHash::add(hash, flight.x);
+        hash = StateHash::add(hash, flight.y);
+        hash = StateHash::add(hash, flight.vx);
+        hash = StateHash::add(hash, flight.vy);
+        hash = StateHash::add(hash, flight.radius);
+        hash = StateHash::add(hash, flight.invMass);
+        hash = StateHash::add(hash, flight.color);
+        hash = StateHash::add(hash, flight.id);
+    }
+    return StateHash::add(hash, flights.size());
+}
+
+void BallisticSet::solveExitTime(Flight& flight) const {
+    // Margins that stay non-negative while on screen (BallStore::isOffScreen)
+    const double x = flight.x, y = flight.y, vx = flight.vx, vy = flight.vy;
+    const double r = flight.radius;
+    const double halfG = 0.5 * gravity;
+
+    double t = NEVER;
+    t = std::min(t, firstNegative(halfG, vy, y - r));                        // Top: y - r >= 0
+    t = std::min(t, firstNegative(-halfG, -vy, screenHeight - r - y));      // Bottom: y + r <= H
+    t = std::min(t, firstNegative(0.0, vx, x + r));                          // Left: x + r >= 0
+    t = std::min(t, firstNegative(0.0, -vx, screenWidth + r - x));          // Right: x - r <= W
+    flight.exitTime = flight.startTime + t;
+}
+
+void BallisticSet::recheck(BallStore& balls, float previousGravity) {
+    size_t write = 0;
+    for (size_t read = 0; read < flights.size(); ++read) {
+        // Current state under the gravity the flight was planned with
+        Flight flight = flights[read];
+        float t = static_cast<float>(clock - flight.startTime);
+        flight.x += flight.vx * t;
+        flight.y += (flight.vy + 0.5f * previousGravity * t) * t;
+        flight.vy += previousGravity * t;
+        flight.startTime = clock;
+
+        if (isEscaping(flight.x, flight.y, flight.vx, flight.vy, flight.radius)) {
+            solveExitTime(flight);
+            flights[write++] = flight;
+        } else {
+            balls.push(flight.x, flight.y, flight.vx, flight.vy, flight.radius, flight.invMass, flight.color, flight.id);
+        }
+    }
+    flights.resize(write);
+    std::make_heap(flights.begin(), flights.end(), Later());
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "BallStore.h"
+#include "Container.h"
+#include "../math/Vector2D.h"
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Balls that have left the container for good.
+// Outside the wall and moving away, a ball only follows a parabola until it
+// leaves the screen, so there is nothing left to simulate: it is taken out
+// of the BallStore, the time it leaves the screen is solved once (same rule
+// as BallStore::isOffScreen) and its position is only evaluated when drawn.
+// Flights are kept in a min-heap by exit time, so retiring the due ones
+// costs O(log n) each.
+//
+// A ball is captured only if it can never come back: it is more than
+// BALLISTIC_CLEARANCE beyond the wall and its distance to the center keeps
+// growing (the derivative of the squared distance is a cubic in time whose
+// coefficients are all non-negative). Flights no longer collide with
+// anything, including each other. A change of gravity or container radius
+// re-tests every flight from its current state; the ones that could reach
+// the wall again go back to the BallStore.
+class BallisticSet {
+public:
+    BallisticSet();
+
+    // Move the clock to the end of the step. Call before the physics step
+    // with the container and gravity it uses; flights that may reach the
+    // wall under new values are appended to balls.
+    void beginStep(BallStore& balls, const Container& container, float gravity, float deltaTime);
+
+    // Whether row index (at the end of the step) has escaped for good.
+    // Sleeping balls and multi-rate balls inside their block are skipped.
+    bool canCapture(const BallStore& balls, size_t index) const;
+
+    // Take over row index; the caller removes it from the store
+    void capture(const BallStore& balls, size_t index, float screenWidth, float screenHeight);
+
+    // Retire the flights that have left the screen by now; returns how many
+    size_t removeExited();
+
+    size_t size() const { return flights.size(); }
+    bool empty() const { return flights.empty(); }
+    void clear() { flights.clear(); clock = 0.0; }
+
+    // Fold the flights and the clock into a StateHash fingerprint
+    uint64_t hashState(uint64_t hash) const;
+
+    // Calls fn(x, y, radius, color) with the current position of every flight
+    template <typename Fn>
+    void forEach(Fn fn) const;
+
+private:
+    struct Flight {
+        double exitTime;        // Absolute time the ball is culled
+        double startTime;       // Time of the initial state below
+        float x, y, vx, vy;
+        float radius;
+        float invMass;
+        SDL_Color color;
+        uint32_t id;
+    };
+
+    // Min-heap by exit time
+    struct Later {
+        bool operator()(const Flight& lhs, const Flight& rhs) const { return lhs.exitTime > rhs.exitTime; }
+    };
+
+    std::vector<Flight> flights;
+    double clock;               // Simulation time at the end of the current step
+    float gravity;
+    Vector2D wallCenter;
+    float wallRadius;
+    float screenWidth, screenHeight;
+
+    bool isEscaping(float px, float py, float vx, float vy, float r) const;
+    void solveExitTime(Flight& flight) const;
+    void recheck(BallStore& balls, float previousGravity);  // Against the current wall and gravity
+};
+
+template <typename Fn>
+void BallisticSet::forEach(Fn fn) const {
+    for (const Flight& flight : flights) {
+        float t = static_cast<float>(clock - flight.startTime);
+        fn(flight.x + flight.vx * t,
+           flight.y + (flight.vy + 0.5f * gravity * t) * t,
+           flight.radius,
+           flight.color);
+    }
+}
@@ -47,3 +47,11 @@ float Container::getGapEndAngle() const {
     float gapAngleRad = MathUtils::degToRad(gapAngleDegrees);
     return currentAngleRad + gapAngleRad;
 }
+
+Vector2D Container::getGapStartDirection() const {
+    return Vector2D::fromAngle(getGapStartAngle());
+}
+
+Vector2D Container::getGapEndDirection() const {
+    return Vector2D::fromAngle(getGapEndAngle());
+}
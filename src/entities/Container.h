@@ -17,15 +17,21 @@ public:
     float getGapStartAngle() const;
     float getGapEndAngle() const;
 
+    // Unit vectors pointing at the gap edges (for trig-free gap tests)
+    Vector2D getGapStartDirection() const;
+    Vector2D getGapEndDirection() const;
+
     // Rendering info
     Vector2D getCenter() const { return center; }
     float getRadius() const { return radius; }
     float getCurrentRotation() const { return currentAngleRad; }
     float getGapAngleDegrees() const { return gapAngleDegrees; }
+    float getRotationSpeed() const { return rotationSpeed; }  // Degrees per second
 
     // Configuration
     void setGapAngleDegrees(float degrees) { gapAngleDegrees = degrees; }
     void setRadius(float newRadius) { radius = newRadius; }
+    void resetRotation() { currentAngleRad = 0.0f; }
 
 private:
     Vector2D center;
@@ -1,13 +1,23 @@
 #include "BallManager.h"
 #include "../core/Config.h"
 #include "../math/MathUtils.h"
+#include "../math/StateHash.h"
 #include <cstdlib>
 #include <ctime>
 
+namespace {
+    // Off-screen scan results
+    constexpr uint8_t REMOVE_NONE = 0;
+    constexpr uint8_t REMOVE_OFF_SCREEN = 1;
+    constexpr uint8_t REMOVE_ESCAPED = 2;    // Handed to the ballistic set
+}
+
 BallManager::BallManager(const Vector2D& spawnCenter, float ballRadius)
     : spawnCenter(spawnCenter)
     , ballRadius(ballRadius)
     , pendingRespawnCount(0)
+    , jobs(nullptr)
+    , ballisticEnabled(false)
 {
     // Seed random number generator
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
@@ -15,24 +25,52 @@ BallManager::BallManager(const Vector2D& spawnCenter, float ballRadius)
 
 void BallManager::spawnInitialBall() {
     Ball ball = createRandomBall(spawnCenter);
-    balls.push_back(ball);
+    balls.push(ball);
+}
+
+void BallManager::beginStep(const Container& container, float gravity, float deltaTime) {
+    ballistic.beginStep(balls, container, gravity, deltaTime);
 }
 
 void BallManager::update(float screenWidth, float screenHeight, int respawnCount) {
-    // Count how many balls are off-screen
-    size_t offScreenCount = 0;
-
-    // Remove balls that exited through any edge
-    auto it = balls.begin();
-    while (it != balls.end()) {
-        if (it->isOffScreen(screenWidth, screenHeight)) {
-            ++offScreenCount;
-            it = balls.erase(it);
-        } else {
-            ++it;
+    // Flag balls that exited through any edge, and balls that escaped the
+    // container for good (independent per ball)
+    offScreenFlags.resize(balls.size());
+    auto scan = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint8_t flag = REMOVE_NONE;
+            if (balls.isOffScreen(i, screenWidth, screenHeight)) {
+                flag = REMOVE_OFF_SCREEN;
+            } else if (ballisticEnabled && ballistic.canCapture(balls, i)) {
+                flag = REMOVE_ESCAPED;
+            }
+            offScreenFlags[i] = flag;
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(balls.size(), Config::PARALLEL_GRAIN_SIZE, scan);
+    } else {
+        scan(0, balls.size());
+    }
+
+    // Escaped balls fly on in the ballistic set
+    size_t escapedCount = 0;
+    if (ballisticEnabled) {
+        for (size_t i = 0; i < balls.size(); ++i) {
+            if (offScreenFlags[i] == REMOVE_ESCAPED) {
+                ballistic.capture(balls, i, screenWidth, screenHeight);
+                ++escapedCount;
+            }
         }
     }
 
+    // Remove them in order (one re-layout for both) and count the ones
+    // that left the screen, simulated or in flight
+    size_t removedCount = balls.removeIf([&](size_t i) {
+        return offScreenFlags[i] != REMOVE_NONE;
+    });
+    size_t offScreenCount = removedCount - escapedCount + ballistic.removeExited();
+
     // Add to pending respawn queue
     if (offScreenCount > 0) {
         pendingRespawnCount += offScreenCount * respawnCount;
@@ -42,11 +80,27 @@ void BallManager::update(float screenWidth, float screenHeight, int respawnCount
     if (pendingRespawnCount > 0 && !wouldCollideWithBalls(spawnCenter)) {
         // Spawn one ball at a time when space is available
         Ball ball = createRandomBall(spawnCenter);
-        balls.push_back(ball);
+        balls.push(ball);
         pendingRespawnCount--;
     }
 }
 
+void BallManager::clear() {
+    balls.clear();
+    ballistic.clear();
+    pendingRespawnCount = 0;
+}
+
+void BallManager::setSeed(unsigned int seed) {
+    std::srand(seed);
+}
+
+uint64_t BallManager::hashState(uint64_t hash) const {
+    hash = balls.hashState(hash);
+    hash = ballistic.hashState(hash);
+    return StateHash::add(hash, pendingRespawnCount);
+}
+
 Ball BallManager::createRandomBall(const Vector2D& position) {
     Vector2D velocity = getRandomVelocity();
     SDL_Color color = getRandomColor();
@@ -82,9 +136,9 @@ void BallManager::removeOffScreenBalls(float screenHeight) {
 bool BallManager::wouldCollideWithBalls(const Vector2D& position) const {
     // Check if spawning a ball at this position would collide with any existing ball
     // Use a safety margin of 2x the combined radii to ensure adequate spacing
-    for (const auto& ball : balls) {
-        float distance = position.distance(ball.position);
-        float minDistance = ballRadius + ball.radius;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        float distance = position.distance(Vector2D(balls.x[i], balls.y[i]));
+        float minDistance = ballRadius + balls.radius[i];
         float safeDistance = minDistance * 2.0f;  // Require 2x spacing
 
         // If distance is less than safe distance, position is not clear
@@ -98,6 +152,6 @@ bool BallManager::wouldCollideWithBalls(const Vector2D& position) const {
 void BallManager::spawnReplacementBalls(size_t count) {
     for (size_t i = 0; i < count; ++i) {
         Ball ball = createRandomBall(spawnCenter);
-        balls.push_back(ball);
+        balls.push(ball);
     }
 }
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "../entities/Ball.h"
+#include "../entities/BallStore.h"
+#include "../entities/BallisticSet.h"
+#include "../entities/Container.h"
 #include "../math/Vector2D.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
 #include <vector>
 
 class BallManager {
@@ -11,25 +16,53 @@ public:
     // Initialize with first ball
     void spawnInitialBall();
 
+    // Call before the physics step with the container and gravity it uses
+    void beginStep(const Container& container, float gravity, float deltaTime);
+
     // Update: remove off-screen balls and spawn replacements
     void update(float screenWidth, float screenHeight, int respawnCount = 2);
 
+    // Remove every ball, simulated, in flight or waiting to respawn
+    void clear();
+
+    // Restart the spawn random sequence (seeded from the clock by default)
+    void setSeed(unsigned int seed);
+
+    // Fold the balls, the flights and the respawn queue into a StateHash fingerprint
+    uint64_t hashState(uint64_t hash) const;
+
     // Access balls
-    std::vector<Ball>& getBalls() { return balls; }
-    const std::vector<Ball>& getBalls() const { return balls; }
+    BallStore& getBalls() { return balls; }
+    const BallStore& getBalls() const { return balls; }
+
+    // Balls that escaped the container, flying out analytically
+    const BallisticSet& getBallistic() const { return ballistic; }
 
     // Stats
-    size_t getBallCount() const { return balls.size(); }
+    size_t getBallCount() const { return balls.size() + ballistic.size(); }
     size_t getPendingRespawnCount() const { return pendingRespawnCount; }
 
     // Configuration
     void setBallRadius(float radius) { ballRadius = radius; }
 
+    // Optional thread pool for the off-screen scan (nullptr = serial)
+    void setJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+    // Ballistic fast path: a ball that has left the container for good is
+    // moved out of the BallStore into the ballistic set, which removes it
+    // when it leaves the screen (it counts toward respawns as usual)
+    void setBallisticEnabled(bool enabled) { ballisticEnabled = enabled; }
+    bool isBallisticEnabled() const { return ballisticEnabled; }
+
 private:
-    std::vector<Ball> balls;
+    BallStore balls;
+    BallisticSet ballistic;
     Vector2D spawnCenter;
     float ballRadius;
     size_t pendingRespawnCount;
+    JobSystem* jobs;
+    bool ballisticEnabled;
+    std::vector<uint8_t> offScreenFlags;  // Scratch for the parallel scan (REMOVE_* values)
 
     // Spawning helpers
     Ball createRandomBall(const Vector2D& position);
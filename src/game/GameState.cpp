@@ -1,8 +1,13 @@
 #include "GameState.h"
 #include "../core/Config.h"
+#include "../math/StateHash.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 
 GameState::GameState()
-    : ballManager(
+    : jobSystem(Config::PHYSICS_THREAD_COUNT, Config::PIN_PHYSICS_THREADS)
+    , ballManager(
         Vector2D(Config::CONTAINER_CENTER_X, Config::CONTAINER_CENTER_Y),
         Config::BALL_RADIUS
     )
@@ -11,8 +16,20 @@ GameState::GameState()
         Config::CONTAINER_RADIUS,
         Config::CONTAINER_GAP_PERCENT * 360.0f  // Convert to degrees
     )
-    , physics(Config::GRAVITY)
+    , physics(
+        Config::GRAVITY,
+        static_cast<float>(Config::WINDOW_WIDTH),
+        static_cast<float>(Config::WINDOW_HEIGHT)
+    )
+    , adaptiveSubsteps(false)
+    , substepCount(1)
+    , deterministic(false)
+    , trace(nullptr)
+    , stateHash(StateHash::SEED)
+    , stepCount(0)
 {
+    ballManager.setJobSystem(&jobSystem);
+    physics.setJobSystem(&jobSystem);
 }
 
 void GameState::initialize() {
@@ -20,10 +37,41 @@ void GameState::initialize() {
     ballManager.spawnInitialBall();
 }
 
+void GameState::reset() {
+    ballManager.clear();
+    container.resetRotation();
+    if (deterministic) {
+        // Ids and spawns feed the state hash
+        Ball::resetIds();
+        ballManager.setSeed(Config::DETERMINISTIC_SEED);
+    }
+    initialize();
+}
+
+void GameState::setDeterministic(bool enabled) {
+    deterministic = enabled;
+    physics.setDeterministic(enabled);
+    if (enabled) {
+        Ball::resetIds();
+        ballManager.setSeed(Config::DETERMINISTIC_SEED);
+    }
+}
+
 void GameState::update(float deltaTime, float restitution, int respawnCount) {
+    substepCount = adaptiveSubsteps ? chooseSubstepCount(deltaTime) : 1;
+    const float substep = deltaTime / static_cast<float>(substepCount);
+    for (int i = 0; i < substepCount; ++i) {
+        step(substep, restitution, respawnCount);
+    }
+}
+
+void GameState::step(float deltaTime, float restitution, int respawnCount) {
     // Update container rotation
     container.update(deltaTime);
 
+    // Start the step for balls flying outside the container
+    ballManager.beginStep(container, physics.getGravity(), deltaTime);
+
     // Update physics simulation
     physics.update(ballManager.getBalls(), container, deltaTime, restitution);
 
@@ -33,6 +81,52 @@ void GameState::update(float deltaTime, float restitution, int respawnCount) {
         static_cast<float>(Config::WINDOW_HEIGHT),
         respawnCount
     );
+
+    if (deterministic) {
+        stateHash = hashState();
+        ++stepCount;
+        if (trace) {
+            trace->addStep(stateHash);
+        }
+    }
+}
+
+uint64_t GameState::hashState() const {
+    uint64_t hash = ballManager.hashState(StateHash::SEED);
+    return StateHash::add(hash, container.getCurrentRotation());
+}
+
+int GameState::chooseSubstepCount(float deltaTime) {
+    // Calm scenes still split anything longer than the largest substep
+    int count = static_cast<int>(std::ceil(deltaTime / Config::SUBSTEP_MAX_TIMESTEP - 1e-4f));
+
+    const BallStore& balls = ballManager.getBalls();
+    if (!balls.empty()) {
+        // Fastest ball and smallest radius (independent per ball)
+        float maxSpeedSquared = 0.0f;
+        float minRadius = balls.radius[0];
+        std::mutex mutex;
+        jobSystem.parallelFor(balls.size(), Config::PARALLEL_GRAIN_SIZE, [&](size_t begin, size_t end) {
+            float speedSquared = 0.0f;
+            float radius = balls.radius[begin];
+            for (size_t i = begin; i < end; ++i) {
+                speedSquared = std::max(speedSquared, balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i]);
+                radius = std::min(radius, balls.radius[i]);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            maxSpeedSquared = std::max(maxSpeedSquared, speedSquared);
+            minRadius = std::min(minRadius, radius);
+        });
+
+        // Gravity can add up to g * deltaTime over the update
+        float speed = std::sqrt(maxSpeedSquared) + std::fabs(physics.getGravity()) * deltaTime;
+        float reach = Config::SUBSTEP_CFL * minRadius;
+        if (reach > 0.0f) {
+            count = std::max(count, static_cast<int>(std::ceil(speed * deltaTime / reach)));
+        }
+    }
+
+    return std::min(std::max(count, 1), Config::SUBSTEP_MAX_COUNT);
 }
 
 size_t GameState::getBallCount() const {
@@ -2,19 +2,49 @@
 
 #include "../entities/Container.h"
 #include "../physics/PhysicsEngine.h"
+#include "../core/JobSystem.h"
 #include "BallManager.h"
+#include "StateTrace.h"
+#include <cstdint>
 
 class GameState {
 public:
     GameState();
 
     void initialize();
+
+    // Remove every ball, turn the container back and initialize again. In
+    // deterministic mode the run then repeats a fresh one.
+    void reset();
+
+    // Advance by deltaTime: one step, or with adaptive substepping as many
+    // equal substeps as the fastest ball needs
     void update(float deltaTime, float restitution, int respawnCount = 2);
 
+    // Adaptive substepping: the substep count follows a CFL-style bound, so
+    // no ball moves more than SUBSTEP_CFL of the smallest radius per
+    // substep, and no substep is longer than SUBSTEP_MAX_TIMESTEP
+    void setAdaptiveSubsteps(bool enabled) { adaptiveSubsteps = enabled; }
+    bool isAdaptiveSubsteps() const { return adaptiveSubsteps; }
+    int getSubstepCount() const { return substepCount; }  // Substeps taken by the last update
+
+    // Deterministic mode: spawning restarts from DETERMINISTIC_SEED, the
+    // physics resolves contacts in an order independent of the thread
+    // count, and every step ends with a 64-bit hash of the full state (the
+    // balls, the flights, the respawn queue and the container rotation),
+    // passed to the trace if one is set. Ball ids restart at 0. Call
+    // before initialize().
+    void setDeterministic(bool enabled);
+    bool isDeterministic() const { return deterministic; }
+    void setStateTrace(StateTrace* trace) { this->trace = trace; }
+    uint64_t getStateHash() const { return stateHash; }  // After the last step
+    size_t getStepCount() const { return stepCount; }    // Steps hashed so far
+
     // Access game objects
     BallManager& getBallManager() { return ballManager; }
     Container& getContainer() { return container; }
     PhysicsEngine& getPhysics() { return physics; }
+    JobSystem& getJobSystem() { return jobSystem; }
 
     const BallManager& getBallManager() const { return ballManager; }
     const Container& getContainer() const { return container; }
@@ -24,7 +54,18 @@ public:
     size_t getPendingRespawnCount() const;
 
 private:
+    JobSystem jobSystem;  // Declared first: outlives the systems using it
     BallManager ballManager;
     Container container;
     PhysicsEngine physics;
+    bool adaptiveSubsteps;
+    int substepCount;
+    bool deterministic;
+    StateTrace* trace;
+    uint64_t stateHash;
+    size_t stepCount;
+
+    void step(float deltaTime, float restitution, int respawnCount);
+    int chooseSubstepCount(float deltaTime);
+    uint64_t hashState() const;
 };
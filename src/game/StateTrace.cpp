@@ -0,0 +1,81 @@
+#include "StateTrace.h"
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+
+StateTrace::StateTrace()
+    : mode(TraceMode::Off)
+    , stepCount(0)
+    , divergedStep(0)
+{
+}
+
+StateTrace::~StateTrace() {
+    finish();
+}
+
+bool StateTrace::open(TraceMode mode, const std::string& path) {
+    this->mode = mode;
+    this->path = path;
+    stepCount = 0;
+    divergedStep = 0;
+    expected.clear();
+
+    if (mode == TraceMode::Record) {
+        output.open(path, std::ios::out | std::ios::trunc);
+        if (!output) {
+            std::cerr << "Cannot create state trace " << path << std::endl;
+            this->mode = TraceMode::Off;
+            return false;
+        }
+    } else if (mode == TraceMode::Verify) {
+        std::ifstream input(path);
+        if (!input) {
+            std::cerr << "Cannot read state trace " << path << std::endl;
+            this->mode = TraceMode::Off;
+            return false;
+        }
+        std::string line;
+        while (std::getline(input, line)) {
+            uint64_t hash = 0;
+            if (std::sscanf(line.c_str(), "%" SCNx64, &hash) != 1) {
+                std::cerr << "Malformed state trace " << path << " at line " << expected.size() + 1 << std::endl;
+                this->mode = TraceMode::Off;
+                return false;
+            }
+            expected.push_back(hash);
+        }
+    }
+    return true;
+}
+
+void StateTrace::addStep(uint64_t hash) {
+    ++stepCount;
+    if (mode == TraceMode::Record) {
+        char line[32];
+        std::snprintf(line, sizeof(line), "%016" PRIx64 "\n", hash);
+        output << line;
+    } else if (mode == TraceMode::Verify && divergedStep == 0 && stepCount <= expected.size()
+               && hash != expected[stepCount - 1]) {
+        divergedStep = stepCount;
+        char message[128];
+        std::snprintf(message, sizeof(message), "State trace diverges at step %zu: expected %016" PRIx64 ", got %016" PRIx64,
+                      stepCount, expected[stepCount - 1], hash);
+        std::cerr << message << std::endl;
+    }
+}
+
+void StateTrace::finish() {
+    if (mode == TraceMode::Record) {
+        output.close();
+        std::cout << "State trace: recorded " << stepCount << " steps to " << path << std::endl;
+    } else if (mode == TraceMode::Verify) {
+        size_t checked = stepCount < expected.size() ? stepCount : expected.size();
+        if (divergedStep != 0) {
+            std::cout << "State trace: diverged from " << path << " at step " << divergedStep << std::endl;
+        } else {
+            std::cout << "State trace: " << checked << " of " << expected.size() << " steps match " << path << std::endl;
+        }
+    }
+    mode = TraceMode::Off;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum class TraceMode {
+    Off,
+    Record,   // Write the hash of every step to a file
+    Verify    // Compare every step against a recorded file
+};
+
+// Per-step state hashes of a deterministic run (see
+// GameState::setDeterministic). A trace file holds one hexadecimal hash per
+// line, step 1 first. Verifying reports the first step whose hash differs
+// from the recorded one; steps past the end of the file are not checked.
+class StateTrace {
+public:
+    StateTrace();
+    ~StateTrace();
+
+    // Create the file to record to, or load the file to verify against.
+    // Prints the reason and returns false if that fails.
+    bool open(TraceMode mode, const std::string& path);
+
+    // Hash of the next step
+    void addStep(uint64_t hash);
+
+    // Close the file and print a summary (once)
+    void finish();
+
+    TraceMode getMode() const { return mode; }
+    size_t getStepCount() const { return stepCount; }
+    bool hasDiverged() const { return divergedStep != 0; }
+    size_t getDivergedStep() const { return divergedStep; }  // First differing step (1-based), 0 = none
+
+private:
+    TraceMode mode;
+    std::string path;
+    std::ofstream output;           // Record
+    std::vector<uint64_t> expected; // Verify
+    size_t stepCount;
+    size_t divergedStep;
+};
@@ -1,11 +1,14 @@
 #include "core/Application.h"
+#include "core/SimulationOptions.h"
 #include <iostream>
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    SimulationOptions options;
+    if (!SimulationOptionsParser::parse(argc, argv, options)) {
+        return 1;
+    }
 
-    Application app;
+    Application app(options);
 
     if (!app.initialize()) {
         std::cerr << "Failed to initialize application" << std::endl;
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 64-bit fingerprint of simulation state for determinism checks.
+// Values are folded in as raw bytes, so two states hash equal only if they
+// are bitwise equal (0.0f and -0.0f differ). Not a cryptographic hash.
+namespace StateHash {
+    constexpr uint64_t SEED = 0xCBF29CE484222325ull;
+
+    inline uint64_t mix(uint64_t hash, uint64_t word) {
+        hash ^= word * 0x9E3779B97F4A7C15ull;
+        hash = (hash << 27) | (hash >> 37);
+        return hash * 0x100000001B3ull + 0x94D049BB133111EBull;
+    }
+
+    inline uint64_t addBytes(uint64_t hash, const void* data, size_t size) {
+        if (size == 0) {
+            return mix(mix(hash, 0), 0);  // data may be null (empty column)
+        }
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            hash = mix(hash, word);
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, bytes + i, size - i);
+        return mix(mix(hash, tail), size);
+    }
+
+    template <typename T>
+    uint64_t add(uint64_t hash, const T& value) {
+        return addBytes(hash, &value, sizeof(T));
+    }
+
+    template <typename T>
+    uint64_t add(uint64_t hash, const std::vector<T>& column) {
+        return addBytes(hash, column.data(), column.size() * sizeof(T));
+    }
+}
@@ -0,0 +1,300 @@
+#include "AabbTree.h"
+#include "../core/Config.h"
+#include <algorithm>
+
+namespace {
+    inline float perimeter(float minX, float minY, float maxX, float maxY) {
+        return 2.0f * ((maxX - minX) + (maxY - minY));
+    }
+}
+
+AabbTree::AabbTree()
+    : root(NULL_NODE)
+    , freeList(NULL_NODE)
+    , layoutVersion(0)
+{
+}
+
+void AabbTree::build(const BallStore& balls, JobSystem* jobs) {
+    followLayout(balls);
+
+    const size_t count = balls.size();
+    ballLeaf.resize(count, NULL_NODE);
+    minX.resize(count);
+    minY.resize(count);
+    maxX.resize(count);
+    maxY.resize(count);
+    escaped.resize(count);
+
+    // Tight boxes and the fat-box containment test are per ball; only the
+    // tree updates below have to run serially
+    auto gather = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float r = balls.radius[i];
+            minX[i] = balls.x[i] - r;
+            minY[i] = balls.y[i] - r;
+            maxX[i] = balls.x[i] + r;
+            maxY[i] = balls.y[i] + r;
+
+            int32_t leaf = ballLeaf[i];
+            if (leaf == NULL_NODE) {
+                escaped[i] = 1;
+                continue;
+            }
+            const Bounds& fat = nodes[leaf].box;
+            escaped[i] = minX[i] < fat.minX || minY[i] < fat.minY || maxX[i] > fat.maxX || maxY[i] > fat.maxY;
+        }
+    };
+
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, gather);
+    } else {
+        gather(0, count);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!escaped[i]) {
+            continue;
+        }
+
+        int32_t leaf = ballLeaf[i];
+        if (leaf == NULL_NODE) {
+            leaf = allocateNode();
+            nodes[leaf].ball = static_cast<uint32_t>(i);
+            ballLeaf[i] = leaf;
+        } else {
+            removeLeaf(leaf);
+        }
+
+        // Margin scales with the ball so small and large balls reinsert
+        // about as often
+        const float margin = Config::AABB_TREE_FAT_MARGIN * balls.radius[i];
+        nodes[leaf].box = {minX[i] - margin, minY[i] - margin, maxX[i] + margin, maxY[i] + margin};
+        insertLeaf(leaf);
+    }
+}
+
+void AabbTree::followLayout(const BallStore& balls) {
+    const uint64_t version = balls.getLayoutVersion();
+    if (version == layoutVersion) {
+        return;
+    }
+
+    if (version != layoutVersion + 1) {
+        // Missed a re-layout: rebuild from scratch
+        reset();
+        layoutVersion = version;
+        return;
+    }
+
+    // Drop the leaves of removed balls and renumber the rest
+    const std::vector<uint32_t>& remap = balls.getLastRemap();
+    std::vector<int32_t> remapped(balls.size(), NULL_NODE);
+    for (size_t old = 0; old < ballLeaf.size(); ++old) {
+        int32_t leaf = ballLeaf[old];
+        if (leaf == NULL_NODE) {
+            continue;
+        }
+
+        uint32_t mapped = old < remap.size() ? remap[old] : BallStore::REMOVED;
+        if (mapped == BallStore::REMOVED) {
+            removeLeaf(leaf);
+            freeNode(leaf);
+        } else {
+            nodes[leaf].ball = mapped;
+            remapped[mapped] = leaf;
+        }
+    }
+    ballLeaf.swap(remapped);
+    layoutVersion = version;
+}
+
+void AabbTree::reset() {
+    nodes.clear();
+    ballLeaf.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+}
+
+int32_t AabbTree::allocateNode() {
+    int32_t node;
+    if (freeList != NULL_NODE) {
+        node = freeList;
+        freeList = nodes[node].parent;
+    } else {
+        node = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    Node& n = nodes[node];
+    n.parent = NULL_NODE;
+    n.child1 = NULL_NODE;
+    n.child2 = NULL_NODE;
+    n.height = 0;
+    return node;
+}
+
+void AabbTree::freeNode(int32_t node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void AabbTree::insertLeaf(int32_t leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling whose box grows the least. Each level
+    // compares "pair the leaf with this node" against the cheapest child,
+    // where every ancestor on the way pays for growing to fit the leaf.
+    const Bounds leafBox = nodes[leaf].box;
+    int32_t index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        Bounds combined = {
+            std::min(node.box.minX, leafBox.minX), std::min(node.box.minY, leafBox.minY),
+            std::max(node.box.maxX, leafBox.maxX), std::max(node.box.maxY, leafBox.maxY)
+        };
+        float area = perimeter(node.box.minX, node.box.minY, node.box.maxX, node.box.maxY);
+        float combinedArea = perimeter(combined.minX, combined.minY, combined.maxX, combined.maxY);
+
+        float cost = 2.0f * combinedArea;                       // New parent here
+        float inheritanceCost = 2.0f * (combinedArea - area);  // Growth pushed onto the ancestors
+
+        auto descendCost = [&](int32_t child) {
+            const Bounds& box = nodes[child].box;
+            float grown = perimeter(std::min(box.minX, leafBox.minX), std::min(box.minY, leafBox.minY),
+                                    std::max(box.maxX, leafBox.maxX), std::max(box.maxY, leafBox.maxY));
+            if (nodes[child].isLeaf()) {
+                return grown + inheritanceCost;
+            }
+            return grown - perimeter(box.minX, box.minY, box.maxX, box.maxY) + inheritanceCost;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    // Splice a new parent above the chosen sibling
+    const int32_t sibling = index;
+    const int32_t oldParent = nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root = newParent;
+    } else if (nodes[oldParent].child1 == sibling) {
+        nodes[oldParent].child1 = newParent;
+    } else {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    // Refit and rebalance up to the root
+    for (index = newParent; index != NULL_NODE; index = nodes[index].parent) {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+void AabbTree::removeLeaf(int32_t leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    // The leaf's parent goes away; the sibling takes its place
+    const int32_t parent = nodes[leaf].parent;
+    const int32_t grandParent = nodes[parent].parent;
+    const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    freeNode(parent);
+
+    nodes[sibling].parent = grandParent;
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent) {
+        nodes[grandParent].child1 = sibling;
+    } else {
+        nodes[grandParent].child2 = sibling;
+    }
+
+    for (int32_t index = grandParent; index != NULL_NODE; index = nodes[index].parent) {
+        index = balance(index);
+        refit(index);
+    }
+}
+
+int32_t AabbTree::balance(int32_t iA) {
+    // Rotate the taller child up if the subtree heights differ by more than
+    // one. Returns the node now at iA's position.
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    const int32_t iB = A.child1;
+    const int32_t iC = A.child2;
+    const int32_t difference = nodes[iC].height - nodes[iB].height;
+    if (difference >= -1 && difference <= 1) {
+        return iA;
+    }
+
+    // P is the taller child that moves up; S stays below A
+    const bool rotateC = difference > 1;
+    const int32_t iP = rotateC ? iC : iB;
+    Node& P = nodes[iP];
+    const int32_t iF = P.child1;
+    const int32_t iG = P.child2;
+
+    // P takes A's place
+    P.child1 = iA;
+    P.parent = A.parent;
+    A.parent = iP;
+    if (P.parent == NULL_NODE) {
+        root = iP;
+    } else if (nodes[P.parent].child1 == iA) {
+        nodes[P.parent].child1 = iP;
+    } else {
+        nodes[P.parent].child2 = iP;
+    }
+
+    // The taller grandchild stays with P, the shorter one moves under A
+    const bool keepF = nodes[iF].height > nodes[iG].height;
+    const int32_t iKeep = keepF ? iF : iG;
+    const int32_t iMove = keepF ? iG : iF;
+    P.child2 = iKeep;
+    if (rotateC) {
+        A.child2 = iMove;
+    } else {
+        A.child1 = iMove;
+    }
+    nodes[iMove].parent = iA;
+
+    refit(iA);
+    refit(iP);
+    return iP;
+}
+
+void AabbTree::refit(int32_t index) {
+    Node& node = nodes[index];
+    const Node& child1 = nodes[node.child1];
+    const Node& child2 = nodes[node.child2];
+    node.height = 1 + std::max(child1.height, child2.height);
+    node.box.minX = std::min(child1.box.minX, child2.box.minX);
+    node.box.minY = std::min(child1.box.minY, child2.box.minY);
+    node.box.maxX = std::max(child1.box.maxX, child2.box.maxX);
+    node.box.maxY = std::max(child1.box.maxY, child2.box.maxY);
+}
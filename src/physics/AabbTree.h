@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Dynamic AABB tree broadphase (bounding volume hierarchy).
+// Every ball owns a leaf whose box is fattened by a margin, so the tree only
+// changes when a ball leaves its fat box: that leaf is removed and
+// reinserted, every other leaf stays where it is. Inserts pick the sibling
+// with the smallest perimeter growth and rotations keep the tree balanced.
+// Pairs come from a tree-vs-tree self query, so a population mixing small
+// and large balls costs no more than a uniform one (unlike the grid, whose
+// cells are sized to the largest ball).
+class AabbTree {
+public:
+    AabbTree();
+
+    // Follow removals/spawns, then reinsert the balls that left their fat box
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every pair whose (tight) bounding boxes overlap
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+private:
+    static constexpr int32_t NULL_NODE = -1;
+
+    struct Bounds {
+        float minX, minY, maxX, maxY;
+    };
+
+    struct Node {
+        Bounds box;      // Fat box for leaves, union of the children otherwise
+        int32_t parent;  // Next free node while on the free list
+        int32_t child1;  // NULL_NODE for leaves
+        int32_t child2;
+        int32_t height;  // 0 for leaves
+        uint32_t ball;   // Ball index (leaves only)
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    std::vector<Node> nodes;
+    int32_t root;
+    int32_t freeList;
+
+    std::vector<int32_t> ballLeaf;  // Ball index -> leaf node
+    uint64_t layoutVersion;         // BallStore layout ballLeaf refers to
+
+    // Tight ball boxes by ball index (gathered each step)
+    std::vector<float> minX, minY, maxX, maxY;
+    std::vector<uint8_t> escaped;  // Ball left its fat box this step
+
+    mutable std::vector<std::pair<int32_t, int32_t>> queryStack;
+
+    void followLayout(const BallStore& balls);
+    void reset();
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t index);
+    void refit(int32_t index);  // Recompute box and height from the children
+
+    static bool overlaps(const Bounds& a, const Bounds& b) {
+        return a.minX <= b.maxX && a.maxX >= b.minX && a.minY <= b.maxY && a.maxY >= b.minY;
+    }
+};
+
+template <typename Visitor>
+void AabbTree::forEachPotentialCollision(Visitor&& visit) const {
+    if (root == NULL_NODE) {
+        return;
+    }
+
+    // Self query: (n, n) expands into both children against themselves and
+    // against each other; (a, b) descends into the taller subtree. Pairs are
+    // only pushed while their fat boxes overlap, and each leaf pair is
+    // reached exactly once.
+    auto pushIfOverlapping = [&](int32_t a, int32_t b) {
+        if (overlaps(nodes[a].box, nodes[b].box)) {
+            queryStack.emplace_back(a, b);
+        }
+    };
+
+    queryStack.clear();
+    queryStack.emplace_back(root, root);
+    while (!queryStack.empty()) {
+        const std::pair<int32_t, int32_t> top = queryStack.back();
+        queryStack.pop_back();
+        const Node& a = nodes[top.first];
+        const Node& b = nodes[top.second];
+
+        if (top.first == top.second) {
+            if (!a.isLeaf()) {
+                queryStack.emplace_back(a.child1, a.child1);
+                queryStack.emplace_back(a.child2, a.child2);
+                pushIfOverlapping(a.child1, a.child2);
+            }
+        } else if (a.isLeaf() && b.isLeaf()) {
+            // Fat boxes overlap; only report pairs whose tight boxes do
+            const uint32_t i = a.ball;
+            const uint32_t j = b.ball;
+            if (minX[i] <= maxX[j] && maxX[i] >= minX[j] && minY[i] <= maxY[j] && maxY[i] >= minY[j]) {
+                visit(i, j);
+            }
+        } else if (b.isLeaf() || (!a.isLeaf() && a.height >= b.height)) {
+            pushIfOverlapping(a.child1, top.second);
+            pushIfOverlapping(a.child2, top.second);
+        } else {
+            pushIfOverlapping(top.first, b.child1);
+            pushIfOverlapping(top.first, b.child2);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// Broadphase implementations share a duck-typed interface so PhysicsEngine
+// can dispatch to them through a template and keep the pair visitor inlined:
+//
+//   void build(const BallStore& balls, JobSystem* jobs);
+//   template <typename Visitor>
+//   void forEachPotentialCollision(Visitor&& visit) const;  // visit(a, b)
+//
+// The implementation is picked at startup (see SimulationOptions) and can be
+// switched at runtime with PhysicsEngine::setBroadphase.
+enum class BroadphaseType {
+    UniformGrid,    // SpatialGrid: flat uniform grid sized to the largest ball
+    SweepAndPrune,  // SweepAndPrune: balls kept sorted along x between steps
+    AabbTree,       // AabbTree: dynamic bounding volume tree, suits mixed ball sizes
+    HierarchicalGrid, // HierarchicalGrid: one grid level per power-of-two ball size
+    SpatialHash,    // SpatialHash: unbounded grid hashed by cell, memory per occupied cell
+    NeighborList,   // NeighborList: Verlet lists with a skin, re-gathered only after enough motion
+    IncrementalGrid // IncrementalGrid: uniform grid that only re-bins balls that changed cell
+};
@@ -1,8 +1,7 @@
 #pragma once
 
 #include "../math/Vector2D.h"
-#include "../entities/Ball.h"
-#include "../entities/Container.h"
+#include "../entities/BallStore.h"
 
 struct CollisionInfo {
     bool hasCollision;
@@ -19,18 +18,5 @@ struct CollisionInfo {
 class CollisionDetector {
 public:
     // Ball-Ball collision detection
-    static CollisionInfo checkBallCollision(const Ball& a, const Ball& b);
-
-    // Ball-Container collision detection (excluding gap)
-    static CollisionInfo checkContainerCollision(
-        const Ball& ball,
-        const Container& container
-    );
-
-private:
-    // Helper: Check if angle is within gap range
-    static bool isAngleInGap(float angle, float gapStart, float gapEnd);
-
-    // Helper: Get angle of point relative to container center
-    static float getAngleFromCenter(const Vector2D& point, const Vector2D& center);
+    static CollisionInfo checkBallCollision(const BallStore& balls, size_t a, size_t b);
 };
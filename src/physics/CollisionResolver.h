@@ -1,17 +1,99 @@
 #pragma once
 
-#include "../entities/Ball.h"
+#include "../entities/BallStore.h"
 #include "CollisionDetector.h"
 
+// What a step knows about its contacts at compile time: restitution is
+// exactly 1, and every ball has the same mass. Either one removes a
+// multiply or the mass-ratio divisions from every resolved pair; results
+// stay bitwise identical to the general path (w / (w + w) is exactly 0.5).
+template <bool Elastic, bool UniformMass>
+struct ContactPolicy {
+    static constexpr bool elastic = Elastic;
+    static constexpr bool uniformMass = UniformMass;
+};
+
+using GeneralContacts = ContactPolicy<false, false>;
+
 class CollisionResolver {
 public:
+    // Resolve an elastic collision under a contact policy. The inverse
+    // masses are ignored under a uniform-mass policy.
+    template <typename Policy>
+    static void resolveContact(BallStore& balls, size_t a, size_t b, const CollisionInfo& info,
+                               float restitution, float invMassA, float invMassB);
+
     // Resolve elastic collision between two balls
-    static void resolveElasticCollision(Ball& a, Ball& b, const CollisionInfo& info, float restitution = 1.0f);
+    static void resolveElasticCollision(BallStore& balls, size_t a, size_t b, const CollisionInfo& info, float restitution = 1.0f);
 
-    // Resolve ball-wall collision
-    static void resolveWallCollision(Ball& ball, const CollisionInfo& info, float restitution = 1.0f);
+    // Same, with the inverse masses given explicitly (0 makes a ball immovable)
+    static void resolveElasticCollision(BallStore& balls, size_t a, size_t b, const CollisionInfo& info,
+                                        float restitution, float invMassA, float invMassB);
 
 private:
     // Separate overlapping balls
-    static void separateBalls(Ball& a, Ball& b, float penetration, const Vector2D& normal);
+    static void separateBalls(BallStore& balls, size_t a, size_t b, float penetration, const Vector2D& normal,
+                              float invMassA, float invMassB);
 };
+
+template <typename Policy>
+inline void CollisionResolver::resolveContact(BallStore& balls, size_t a, size_t b, const CollisionInfo& info,
+                                              float restitution, float invMassA, float invMassB) {
+    if (!info.hasCollision) {
+        return;
+    }
+
+    // Get collision normal
+    Vector2D normal = info.normal;
+
+    // Project velocities onto collision normal
+    float v1n = balls.vx[a] * normal.x + balls.vy[a] * normal.y;
+    float v2n = balls.vx[b] * normal.x + balls.vy[b] * normal.y;
+
+    // Velocity along the normal (relative velocity of b with respect to a)
+    float velocityAlongNormal = v2n - v1n;
+
+    // Don't resolve if balls are separating
+    if (velocityAlongNormal > 0.0f) {
+        return;
+    }
+
+    // Elastic collision along the normal:
+    // v1' = ((m1 - m2) * v1 + 2 * m2 * v2) / (m1 + m2)
+    // v2' = ((m2 - m1) * v2 + 2 * m1 * v1) / (m1 + m2)
+    // The changes reduce to 2 * m2 / (m1 + m2) * (v2 - v1) and its mirror;
+    // written with inverse masses, m2 / (m1 + m2) = w1 / (w1 + w2). Equal
+    // masses exchange the normal velocities.
+    float v1n_change, v2n_change;
+    if constexpr (Policy::uniformMass) {
+        v1n_change = velocityAlongNormal;
+        v2n_change = -velocityAlongNormal;
+    } else {
+        float totalInvMass = invMassA + invMassB;
+        v1n_change = 2.0f * (invMassA / totalInvMass) * velocityAlongNormal;
+        v2n_change = -2.0f * (invMassB / totalInvMass) * velocityAlongNormal;
+    }
+
+    // Apply restitution coefficient
+    if constexpr (!Policy::elastic) {
+        v1n_change *= restitution;
+        v2n_change *= restitution;
+    }
+
+    // Update velocities
+    balls.vx[a] += normal.x * v1n_change;
+    balls.vy[a] += normal.y * v1n_change;
+    balls.vx[b] += normal.x * v2n_change;
+    balls.vy[b] += normal.y * v2n_change;
+
+    // Separate balls to prevent overlap (lighter ball moves further)
+    if constexpr (Policy::uniformMass) {
+        float separation = info.penetration * 0.5f;
+        balls.x[a] -= normal.x * separation;
+        balls.y[a] -= normal.y * separation;
+        balls.x[b] += normal.x * separation;
+        balls.y[b] += normal.y * separation;
+    } else {
+        separateBalls(balls, a, b, info.penetration, normal, invMassA, invMassB);
+    }
+}
@@ -0,0 +1,279 @@
+#include "ContactSolver.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    uint64_t pairKey(uint32_t idA, uint32_t idB) {
+        uint32_t low = std::min(idA, idB);
+        uint32_t high = std::max(idA, idB);
+        return (static_cast<uint64_t>(high) << 32) | low;
+    }
+}
+
+void ContactSolver::begin(const BallStore& balls) {
+    contacts.clear();
+    pseudoVx.assign(balls.size(), 0.0f);
+    pseudoVy.assign(balls.size(), 0.0f);
+}
+
+void ContactSolver::addBallContact(const BallStore& balls, uint32_t a, uint32_t b) {
+    float dx = balls.x[b] - balls.x[a];
+    float dy = balls.y[b] - balls.y[a];
+    float reach = balls.radius[a] + balls.radius[b];
+    float distanceSquared = dx * dx + dy * dy;
+    if (distanceSquared >= reach * reach) {
+        return;
+    }
+
+    float wA = inverseMass(balls, a);
+    float wB = inverseMass(balls, b);
+    if (wA + wB <= 0.0f) {
+        return;
+    }
+
+    // Coincident centers: push apart along x, like CollisionDetector
+    float distance = std::sqrt(distanceSquared);
+    float normalX = 1.0f;
+    float normalY = 0.0f;
+    if (distance > 0.0f) {
+        normalX = dx / distance;
+        normalY = dy / distance;
+    }
+
+    Contact contact;
+    contact.a = a;
+    contact.b = b;
+    contact.normalX = normalX;
+    contact.normalY = normalY;
+    contact.penetration = reach - distance;
+    contact.invMassA = wA;
+    contact.invMassB = wB;
+    contact.normalMass = 1.0f / (wA + wB);
+    contact.targetVelocity = 0.0f;
+    contact.impulse = 0.0f;
+    contact.pseudoImpulse = 0.0f;
+    contact.key = pairKey(balls.id[a], balls.id[b]);
+    contacts.push_back(contact);
+}
+
+void ContactSolver::addWallContacts(const BallStore& balls, const ContainerKernel::Params& params) {
+    const size_t count = balls.size();
+    for (size_t i = 0; i < count; ++i) {
+        float wA = inverseMass(balls, static_cast<uint32_t>(i));
+        if (wA <= 0.0f) {
+            continue;
+        }
+
+        // Same bands as ContainerKernel: inner wall up to the rim, outer wall past it
+        float dx = balls.x[i] - params.centerX;
+        float dy = balls.y[i] - params.centerY;
+        float distanceSquared = dx * dx + dy * dy;
+        float r = balls.radius[i];
+        float inner = params.radius - r;
+        float outer = params.radius + r;
+        if ((inner > 0.0f && distanceSquared <= inner * inner) || distanceSquared >= outer * outer) {
+            continue;
+        }
+        if (ContainerKernel::isInGap(dx, dy, params)) {
+            continue;
+        }
+
+        float distance = std::sqrt(distanceSquared);
+        if (distance <= 0.0f) {
+            continue;
+        }
+
+        // The wall is body b: the normal points from the ball into the wall
+        Contact contact;
+        contact.a = static_cast<uint32_t>(i);
+        contact.b = WALL;
+        if (distance <= params.radius) {
+            contact.normalX = dx / distance;
+            contact.normalY = dy / distance;
+            contact.penetration = distance - inner;
+        } else {
+            contact.normalX = -dx / distance;
+            contact.normalY = -dy / distance;
+            contact.penetration = outer - distance;
+        }
+        contact.invMassA = wA;
+        contact.invMassB = 0.0f;
+        contact.normalMass = 1.0f / wA;
+        contact.targetVelocity = 0.0f;
+        contact.impulse = 0.0f;
+        contact.pseudoImpulse = 0.0f;
+        contact.key = pairKey(balls.id[i], WALL);
+        contacts.push_back(contact);
+    }
+}
+
+void ContactSolver::solve(BallStore& balls, float deltaTime, float restitution, int iterations) {
+    prepare(balls, restitution);
+    for (int k = 0; k < iterations; ++k) {
+        solveVelocities(balls);
+    }
+    solvePositions(balls, deltaTime);
+    storeImpulses();
+}
+
+void ContactSolver::prepare(BallStore& balls, float restitution) {
+    // Restitution targets from the approach speeds before any impulse (so
+    // before warm starting); slow approaches such as resting contacts under
+    // gravity do not bounce
+    for (Contact& c : contacts) {
+        float relativeX = -balls.vx[c.a];
+        float relativeY = -balls.vy[c.a];
+        if (c.b != WALL) {
+            relativeX += balls.vx[c.b];
+            relativeY += balls.vy[c.b];
+        }
+        float normalVelocity = relativeX * c.normalX + relativeY * c.normalY;
+        if (normalVelocity < -Config::SOLVER_RESTITUTION_THRESHOLD) {
+            c.targetVelocity = -restitution * normalVelocity;
+        }
+    }
+
+    // Warm start resting contacts with last step's impulse for the same
+    // pair. Impacts start from zero: re-applying a bounce would add energy.
+    for (Contact& c : contacts) {
+        if (c.targetVelocity != 0.0f) {
+            continue;
+        }
+        if (!cache.find(c.key, c.impulse)) {
+            continue;
+        }
+        float px = c.normalX * c.impulse;
+        float py = c.normalY * c.impulse;
+        balls.vx[c.a] -= px * c.invMassA;
+        balls.vy[c.a] -= py * c.invMassA;
+        if (c.b != WALL) {
+            balls.vx[c.b] += px * c.invMassB;
+            balls.vy[c.b] += py * c.invMassB;
+        }
+    }
+}
+
+void ContactSolver::solveVelocities(BallStore& balls) {
+    for (Contact& c : contacts) {
+        float relativeX = -balls.vx[c.a];
+        float relativeY = -balls.vy[c.a];
+        if (c.b != WALL) {
+            relativeX += balls.vx[c.b];
+            relativeY += balls.vy[c.b];
+        }
+        float normalVelocity = relativeX * c.normalX + relativeY * c.normalY;
+
+        // Clamp the accumulated impulse, not the increment
+        float lambda = c.normalMass * (c.targetVelocity - normalVelocity);
+        float accumulated = std::max(c.impulse + lambda, 0.0f);
+        lambda = accumulated - c.impulse;
+        c.impulse = accumulated;
+
+        float px = c.normalX * lambda;
+        float py = c.normalY * lambda;
+        balls.vx[c.a] -= px * c.invMassA;
+        balls.vy[c.a] -= py * c.invMassA;
+        if (c.b != WALL) {
+            balls.vx[c.b] += px * c.invMassB;
+            balls.vy[c.b] += py * c.invMassB;
+        }
+    }
+}
+
+void ContactSolver::solvePositions(BallStore& balls, float deltaTime) {
+    // Split impulse: drive pseudo velocities towards removing a fraction of
+    // the overlap beyond the slop this step, then move by them
+    const float inverseDt = 1.0f / deltaTime;
+    for (int k = 0; k < Config::SOLVER_POSITION_ITERATIONS; ++k) {
+        for (Contact& c : contacts) {
+            float relativeX = -pseudoVx[c.a];
+            float relativeY = -pseudoVy[c.a];
+            if (c.b != WALL) {
+                relativeX += pseudoVx[c.b];
+                relativeY += pseudoVy[c.b];
+            }
+            float normalVelocity = relativeX * c.normalX + relativeY * c.normalY;
+
+            float slop = Config::SOLVER_SLOP_RATIO * balls.radius[c.a];
+            float target = Config::SOLVER_POSITION_BETA * inverseDt * std::max(c.penetration - slop, 0.0f);
+            float lambda = c.normalMass * (target - normalVelocity);
+            float accumulated = std::max(c.pseudoImpulse + lambda, 0.0f);
+            lambda = accumulated - c.pseudoImpulse;
+            c.pseudoImpulse = accumulated;
+
+            float px = c.normalX * lambda;
+            float py = c.normalY * lambda;
+            pseudoVx[c.a] -= px * c.invMassA;
+            pseudoVy[c.a] -= py * c.invMassA;
+            if (c.b != WALL) {
+                pseudoVx[c.b] += px * c.invMassB;
+                pseudoVy[c.b] += py * c.invMassB;
+            }
+        }
+    }
+
+    const size_t count = balls.size();
+    for (size_t i = 0; i < count; ++i) {
+        balls.x[i] += pseudoVx[i] * deltaTime;
+        balls.y[i] += pseudoVy[i] * deltaTime;
+    }
+}
+
+void ContactSolver::storeImpulses() {
+    cacheScratch.reset(contacts.size() * 2);
+    for (const Contact& c : contacts) {
+        if (c.impulse > 0.0f && c.targetVelocity == 0.0f) {
+            cacheScratch.insert(c.key, c.impulse);
+        }
+    }
+    std::swap(cache, cacheScratch);
+}
+
+void ContactSolver::ImpulseTable::reset(size_t minSlots) {
+    // Power-of-two capacity, at most half full; growing clears the table
+    if (minSlots > slotKey.size()) {
+        size_t capacity = 64;
+        while (capacity < minSlots) {
+            capacity *= 2;
+        }
+        slotKey.resize(capacity);
+        slotImpulse.resize(capacity);
+        slotGeneration.assign(capacity, 0);
+        slotMask = static_cast<uint32_t>(capacity - 1);
+        generation = 0;
+    }
+
+    ++generation;
+    if (generation == 0) {
+        // Wrapped: stale slots could alias the new generation
+        std::fill(slotGeneration.begin(), slotGeneration.end(), 0);
+        generation = 1;
+    }
+}
+
+bool ContactSolver::ImpulseTable::find(uint64_t key, float& impulse) const {
+    if (slotKey.empty()) {
+        return false;
+    }
+    for (uint32_t slot = slotFor(key);; slot = (slot + 1) & slotMask) {
+        if (slotGeneration[slot] != generation) {
+            return false;
+        }
+        if (slotKey[slot] == key) {
+            impulse = slotImpulse[slot];
+            return true;
+        }
+    }
+}
+
+void ContactSolver::ImpulseTable::insert(uint64_t key, float impulse) {
+    // A pair is visited once per step, so the key cannot already be present
+    uint32_t slot = slotFor(key);
+    while (slotGeneration[slot] == generation) {
+        slot = (slot + 1) & slotMask;
+    }
+    slotKey[slot] = key;
+    slotImpulse[slot] = impulse;
+    slotGeneration[slot] = generation;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "ContainerKernel.h"
+#include <cstdint>
+#include <vector>
+
+// Sequential-impulse contact solver.
+// Contacts (touching ball pairs and ball-wall contacts) are gathered at the
+// start of the step, before positions move. solve() then applies, for a
+// fixed number of iterations, the normal impulse that brings each contact's
+// relative normal velocity to its target: zero for resting contacts, or
+// -restitution times the approach speed for impacts faster than
+// SOLVER_RESTITUTION_THRESHOLD. Accumulated impulses are clamped to be
+// non-negative, so contacts push but never pull.
+//
+// Impulses are cached per ball-id pair and applied up front on the next
+// step (warm starting), so a resting pile starts each step close to the
+// solution instead of from zero. The cache is a pair of open-addressing
+// tables (last step's, read; this step's, written) invalidated by a
+// generation counter, so lookups and stores are O(1) and nothing is cleared
+// or sorted per step. Overlap is removed by split impulses: a
+// separate pseudo-velocity pass moves the positions and is discarded
+// afterwards, so position correction never adds kinetic energy.
+//
+// Sleeping balls (BallStore::island != 0) take part with infinite mass.
+class ContactSolver {
+public:
+    // Start gathering contacts for this step
+    void begin(const BallStore& balls);
+
+    // Add a contact for a and b if they overlap
+    void addBallContact(const BallStore& balls, uint32_t a, uint32_t b);
+
+    // Add wall contacts for every ball touching the container outside the gap
+    void addWallContacts(const BallStore& balls, const ContainerKernel::Params& params);
+
+    // Warm start, iterate and correct positions; updates the impulse cache
+    void solve(BallStore& balls, float deltaTime, float restitution, int iterations);
+
+    size_t getContactCount() const { return contacts.size(); }
+
+private:
+    static constexpr uint32_t WALL = 0xFFFFFFFFu;  // Body b of a ball-wall contact
+
+    struct Contact {
+        uint32_t a, b;          // b == WALL for the container
+        float normalX, normalY; // From a towards b
+        float penetration;
+        float invMassA, invMassB;  // 0 for the wall and for sleeping balls
+        float normalMass;       // 1 / (wA + wB)
+        float targetVelocity;   // Relative normal velocity the contact should reach
+        float impulse;          // Accumulated normal impulse
+        float pseudoImpulse;    // Accumulated split impulse
+        uint64_t key;           // Ball-id pair (or id + WALL) for the cache
+    };
+
+    // Open-addressing (linear probing) impulse table; a slot is live if its
+    // generation matches the table's
+    struct ImpulseTable {
+        std::vector<uint64_t> slotKey;
+        std::vector<float> slotImpulse;
+        std::vector<uint32_t> slotGeneration;
+        uint32_t generation = 0;
+        uint32_t slotMask = 0;
+
+        void reset(size_t minSlots);  // Empty, with room for minSlots / 2 entries
+        bool find(uint64_t key, float& impulse) const;
+        void insert(uint64_t key, float impulse);
+        uint32_t slotFor(uint64_t key) const {
+            return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & slotMask;
+        }
+    };
+
+    std::vector<Contact> contacts;
+    ImpulseTable cache;                      // Last step's impulses
+    ImpulseTable cacheScratch;               // This step's, swapped in by storeImpulses
+    std::vector<float> pseudoVx, pseudoVy;   // Split-impulse velocities per ball
+
+    float inverseMass(const BallStore& balls, uint32_t ball) const {
+        return balls.island[ball] != 0 ? 0.0f : balls.invMass[ball];
+    }
+    void prepare(BallStore& balls, float restitution);
+    void solveVelocities(BallStore& balls);
+    void solvePositions(BallStore& balls, float deltaTime);
+    void storeImpulses();
+};
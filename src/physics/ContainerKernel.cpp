@@ -0,0 +1,163 @@
+#include "ContainerKernel.h"
+#include "../math/MathUtils.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace ContainerKernel {
+
+namespace {
+    // Widen the SIMD band slightly so float rounding in the squared test
+    // never culls a ball the exact scalar test would collide
+    constexpr float BAND_SLACK = 1e-3f;
+
+    // Exact wall test and response for one ball: outside the gap, a ball
+    // overlapping the wall from inside or outside and moving into it is
+    // reflected with restitution and pushed back out along the normal
+    inline void resolveBall(float& x, float& y, float& vx, float& vy, float r, const Params& params) {
+        float dx = x - params.centerX;
+        float dy = y - params.centerY;
+
+        // Skip collision if in gap area
+        if (isInGap(dx, dy, params)) {
+            return;
+        }
+
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance <= 0.0f) {
+            return;
+        }
+        float innerRadius = params.radius - r;
+        float outerRadius = params.radius + r;
+
+        float normalX, normalY, penetration;
+        if (distance > innerRadius && distance <= params.radius) {
+            // Inner wall: normal points outward from center
+            normalX = dx / distance;
+            normalY = dy / distance;
+            penetration = distance - innerRadius;
+        } else if (distance > params.radius && distance < outerRadius) {
+            // Outer wall: normal points inward toward center
+            normalX = -dx / distance;
+            normalY = -dy / distance;
+            penetration = outerRadius - distance;
+        } else {
+            return;
+        }
+
+        // Don't resolve if ball is moving away from wall
+        float velocityAlongNormal = vx * normalX + vy * normalY;
+        if (velocityAlongNormal < 0.0f) {
+            return;
+        }
+
+        float impulse = 2.0f * velocityAlongNormal * params.restitution;
+        vx -= normalX * impulse;
+        vy -= normalY * impulse;
+        x -= normalX * penetration;
+        y -= normalY * penetration;
+    }
+
+    inline void resolveScalar(float* x, float* y, float* vx, float* vy, const float* radius,
+                              size_t begin, size_t end, const Params& params) {
+        for (size_t i = begin; i < end; ++i) {
+            float dx = x[i] - params.centerX;
+            float dy = y[i] - params.centerY;
+            float distanceSquared = dx * dx + dy * dy;
+            float inner = params.radius - radius[i];
+            float outer = params.radius + radius[i];
+            if (inner > 0.0f && distanceSquared < inner * inner * (1.0f - BAND_SLACK)) {
+                continue;
+            }
+            if (distanceSquared > outer * outer * (1.0f + BAND_SLACK)) {
+                continue;
+            }
+            resolveBall(x[i], y[i], vx[i], vy[i], radius[i], params);
+        }
+    }
+}
+
+Params makeParams(const Container& container, float restitution) {
+    Params params;
+    Vector2D center = container.getCenter();
+    Vector2D gapStart = container.getGapStartDirection();
+    Vector2D gapEnd = container.getGapEndDirection();
+    float gapAngle = MathUtils::degToRad(container.getGapAngleDegrees());
+
+    params.centerX = center.x;
+    params.centerY = center.y;
+    params.radius = container.getRadius();
+    params.gapStartX = gapStart.x;
+    params.gapStartY = gapStart.y;
+    params.gapEndX = gapEnd.x;
+    params.gapEndY = gapEnd.y;
+    // Zero (or full-circle) gaps never match, as in MathUtils::isAngleInRange
+    params.hasGap = gapAngle > 0.0001f && gapAngle < MathUtils::TWO_PI - 0.0001f;
+    params.wideGap = gapAngle > MathUtils::PI;
+    params.restitution = restitution;
+    return params;
+}
+
+void resolve(float* x, float* y, float* vx, float* vy, const float* radius,
+             size_t count, const Params& params) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 centerX = _mm256_set1_ps(params.centerX);
+    const __m256 centerY = _mm256_set1_ps(params.centerY);
+    const __m256 wallRadius = _mm256_set1_ps(params.radius);
+    const __m256 innerScale = _mm256_set1_ps(1.0f - BAND_SLACK);
+    const __m256 outerScale = _mm256_set1_ps(1.0f + BAND_SLACK);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), centerX);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), centerY);
+        __m256 distanceSquared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 inner = _mm256_max_ps(_mm256_sub_ps(wallRadius, r), zero);
+        __m256 outer = _mm256_add_ps(wallRadius, r);
+        __m256 pastInner = _mm256_cmp_ps(distanceSquared, _mm256_mul_ps(_mm256_mul_ps(inner, inner), innerScale), _CMP_GE_OQ);
+        __m256 beforeOuter = _mm256_cmp_ps(distanceSquared, _mm256_mul_ps(_mm256_mul_ps(outer, outer), outerScale), _CMP_LE_OQ);
+        int mask = _mm256_movemask_ps(_mm256_and_ps(pastInner, beforeOuter));
+        for (int lane = 0; mask; ++lane, mask >>= 1) {
+            if (mask & 1) {
+                size_t k = i + lane;
+                resolveBall(x[k], y[k], vx[k], vy[k], radius[k], params);
+            }
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 centerX = _mm_set1_ps(params.centerX);
+    const __m128 centerY = _mm_set1_ps(params.centerY);
+    const __m128 wallRadius = _mm_set1_ps(params.radius);
+    const __m128 innerScale = _mm_set1_ps(1.0f - BAND_SLACK);
+    const __m128 outerScale = _mm_set1_ps(1.0f + BAND_SLACK);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), centerX);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), centerY);
+        __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 inner = _mm_max_ps(_mm_sub_ps(wallRadius, r), zero);
+        __m128 outer = _mm_add_ps(wallRadius, r);
+        __m128 pastInner = _mm_cmpge_ps(distanceSquared, _mm_mul_ps(_mm_mul_ps(inner, inner), innerScale));
+        __m128 beforeOuter = _mm_cmple_ps(distanceSquared, _mm_mul_ps(_mm_mul_ps(outer, outer), outerScale));
+        int mask = _mm_movemask_ps(_mm_and_ps(pastInner, beforeOuter));
+        for (int lane = 0; mask; ++lane, mask >>= 1) {
+            if (mask & 1) {
+                size_t k = i + lane;
+                resolveBall(x[k], y[k], vx[k], vy[k], radius[k], params);
+            }
+        }
+    }
+#endif
+
+    // Scalar tail
+    resolveScalar(x, y, vx, vy, radius, i, count, params);
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../entities/Container.h"
+#include <cstddef>
+
+// Vectorized ball-container collision over the BallStore columns.
+// A SIMD pass (AVX2 / SSE2 / scalar, chosen like IntegrationKernel) tests
+// squared distances against the wall band and skips every ball that is
+// clearly inside or outside it. Only balls in the band get the scalar
+// gap test, which uses cross products with the gap-edge directions
+// instead of atan2 and angle normalization.
+namespace ContainerKernel {
+    struct Params {
+        float centerX, centerY;
+        float radius;
+        float gapStartX, gapStartY;  // Unit vector at the gap start angle
+        float gapEndX, gapEndY;      // Unit vector at the gap end angle
+        bool hasGap;                 // False for a zero-width gap
+        bool wideGap;                // Gap wider than 180°
+        float restitution;
+    };
+
+    // Precompute the per-step constants from the container
+    Params makeParams(const Container& container, float restitution);
+
+    // Resolve wall contacts for balls [0, count)
+    void resolve(float* x, float* y, float* vx, float* vy, const float* radius,
+                 size_t count, const Params& params);
+
+    // True if direction (dx, dy) from the center points into the gap
+    inline bool isInGap(float dx, float dy, const Params& params) {
+        if (!params.hasGap) {
+            return false;
+        }
+        float afterStart = params.gapStartX * dy - params.gapStartY * dx;  // cross(start, d)
+        float beforeEnd = dx * params.gapEndY - dy * params.gapEndX;        // cross(d, end)
+        if (params.wideGap) {
+            return afterStart >= 0.0f || beforeEnd >= 0.0f;
+        }
+        return afterStart >= 0.0f && beforeEnd >= 0.0f;
+    }
+}
@@ -0,0 +1,225 @@
+#include "ContinuousCollision.h"
+#include "../core/Config.h"
+#include "../math/MathUtils.h"
+#include <cmath>
+
+namespace ContinuousCollision {
+
+namespace {
+    struct Hit {
+        float time;               // Since the start of the swept interval
+        float normalX, normalY;   // From the ball into the wall
+        float wallVx, wallVy;     // Wall velocity at the contact (gap edges move)
+    };
+
+    // Direction (x, y) rotated by angle radians
+    inline void rotate(float x, float y, float angle, float& outX, float& outY) {
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        outX = x * c - y * s;
+        outY = x * s + y * c;
+    }
+
+    // Gap test at `time` into the step: the gap was rotationRate * (dt - time)
+    // behind its end-of-step position, so turn the direction forward instead
+    inline bool isInGapAt(float dx, float dy, float time, const Params& params) {
+        if (!params.wall.hasGap) {
+            return false;
+        }
+        float rx, ry;
+        rotate(dx, dy, params.rotationRate * (params.deltaTime - time), rx, ry);
+        return ContainerKernel::isInGap(rx, ry, params.wall);
+    }
+
+    // First contact of the swept ball with one gap edge, a point on the rim
+    // moving from its position at `elapsed` to the one at `elapsed + limit`
+    void sweepEdge(float px, float py, float vx, float vy, float r,
+                   float edgeX, float edgeY, float elapsed, float limit,
+                   const Params& params, Hit& best, bool& found) {
+        const float wallRadius = params.wall.radius;
+        float startX, startY, endX, endY;
+        rotate(edgeX, edgeY, -params.rotationRate * (params.deltaTime - elapsed), startX, startY);
+        rotate(edgeX, edgeY, -params.rotationRate * (params.deltaTime - elapsed - limit), endX, endY);
+        startX = params.wall.centerX + wallRadius * startX;
+        startY = params.wall.centerY + wallRadius * startY;
+        float wallVx = (params.wall.centerX + wallRadius * endX - startX) / limit;
+        float wallVy = (params.wall.centerY + wallRadius * endY - startY) / limit;
+
+        // Relative motion; skip if already touching or moving apart
+        float qx = px - startX;
+        float qy = py - startY;
+        float ux = vx - wallVx;
+        float uy = vy - wallVy;
+        float a = ux * ux + uy * uy;
+        float b = qx * ux + qy * uy;
+        float c = qx * qx + qy * qy - r * r;
+        if (a <= 0.0f || b >= 0.0f || c <= 0.0f) {
+            return;
+        }
+        float discriminant = b * b - a * c;
+        if (discriminant < 0.0f) {
+            return;
+        }
+        float t = (-b - std::sqrt(discriminant)) / a;
+        if (t > best.time) {
+            return;
+        }
+
+        float nx = -(qx + ux * t);
+        float ny = -(qy + uy * t);
+        float length = std::sqrt(nx * nx + ny * ny);
+        if (length <= 0.0f) {
+            return;
+        }
+        best = Hit{t, nx / length, ny / length, wallVx, wallVy};
+        found = true;
+    }
+
+    // Earliest wall contact within `limit` of a ball at (px, py) moving at
+    // (vx, vy), `elapsed` into the step
+    bool findFirstHit(float px, float py, float vx, float vy, float r,
+                      float elapsed, float limit, const Params& params, Hit& best) {
+        const ContainerKernel::Params& wall = params.wall;
+        float qx = px - wall.centerX;
+        float qy = py - wall.centerY;
+        float a = vx * vx + vy * vy;
+        if (a <= 0.0f || limit <= 0.0f) {
+            return false;
+        }
+        float b = qx * vx + qy * vy;
+        float distanceSquared = qx * qx + qy * qy;
+
+        best = Hit{limit, 0.0f, 0.0f, 0.0f, 0.0f};
+        bool found = false;
+
+        // Arc from inside: leaving the circle of radius R - r. A ball that
+        // starts the step inside the band (pushed there by a ball-ball
+        // separation) and moves outwards is touching it already.
+        float inner = wall.radius - r;
+        if (distanceSquared <= wall.radius * wall.radius && (inner <= 0.0f || distanceSquared < inner * inner || b > 0.0f)) {
+            float t = 0.0f;
+            if (inner > 0.0f && distanceSquared < inner * inner) {
+                float c = distanceSquared - inner * inner;
+                t = (-b + std::sqrt(b * b - a * c)) / a;
+            }
+            float hx = qx + vx * t;
+            float hy = qy + vy * t;
+            float length = std::sqrt(hx * hx + hy * hy);
+            if (t <= best.time && length > 0.0f && !isInGapAt(hx, hy, elapsed + t, params)) {
+                best = Hit{t, hx / length, hy / length, 0.0f, 0.0f};
+                found = true;
+            }
+        }
+
+        // Arc from outside: entering the circle of radius R + r (or already
+        // in the outer band and moving inwards)
+        float outer = wall.radius + r;
+        if (distanceSquared > wall.radius * wall.radius && b < 0.0f) {
+            float t = 0.0f;
+            bool reaches = true;
+            if (distanceSquared > outer * outer) {
+                float c = distanceSquared - outer * outer;
+                float discriminant = b * b - a * c;
+                reaches = discriminant >= 0.0f;
+                t = reaches ? (-b - std::sqrt(discriminant)) / a : 0.0f;
+            }
+            float hx = qx + vx * t;
+            float hy = qy + vy * t;
+            float length = std::sqrt(hx * hx + hy * hy);
+            if (reaches && t <= best.time && !isInGapAt(hx, hy, elapsed + t, params)) {
+                best = Hit{t, -hx / length, -hy / length, 0.0f, 0.0f};
+                found = true;
+            }
+        }
+
+        // The ends of the arc
+        if (wall.hasGap) {
+            sweepEdge(px, py, vx, vy, r, wall.gapStartX, wall.gapStartY, elapsed, limit, params, best, found);
+            sweepEdge(px, py, vx, vy, r, wall.gapEndX, wall.gapEndY, elapsed, limit, params, best, found);
+        }
+        return found;
+    }
+}
+
+Params makeParams(const Container& container, float restitution, float deltaTime, float driftLag) {
+    Params params;
+    params.wall = ContainerKernel::makeParams(container, restitution);
+    params.rotationRate = MathUtils::degToRad(container.getRotationSpeed());
+    params.deltaTime = deltaTime;
+    params.driftLag = driftLag;
+    return params;
+}
+
+bool isFast(float vx, float vy, float radius, float deltaTime) {
+    float reach = Config::CCD_DISPLACEMENT_RATIO * radius;
+    return (vx * vx + vy * vy) * deltaTime * deltaTime > reach * reach;
+}
+
+int sweep(float& x, float& y, float& vx, float& vy, float radius, const Params& params) {
+    // The step moved the ball in a straight line at the drift velocity:
+    // (vx, vy) after semi-implicit Euler, (vx, vy - g h / 2) after the
+    // Verlet integrators, whose last half kick came after the drift
+    const float deltaTime = params.deltaTime;
+    const float lag = params.driftLag * deltaTime;
+    float driftVy = vy - lag;
+    float px = x - vx * deltaTime;
+    float py = y - driftVy * deltaTime;
+    float elapsed = 0.0f;
+    int hits = 0;
+
+    Hit hit;
+    while (findFirstHit(px, py, vx, driftVy, radius, elapsed, deltaTime - elapsed, params, hit)) {
+        px += vx * hit.time;
+        py += driftVy * hit.time;
+        elapsed += hit.time;
+
+        // Same response as the discrete wall test, relative to the wall
+        float velocityAlongNormal = (vx - hit.wallVx) * hit.normalX + (driftVy - hit.wallVy) * hit.normalY;
+        if (velocityAlongNormal > 0.0f) {
+            float impulse = 2.0f * velocityAlongNormal * params.wall.restitution;
+            vx -= hit.normalX * impulse;
+            driftVy -= hit.normalY * impulse;
+        }
+
+        // Out of hits: stop at the contact rather than pass through
+        if (++hits == Config::CCD_MAX_HITS) {
+            x = px;
+            y = py;
+            vy = driftVy + lag;
+            return hits;
+        }
+    }
+
+    if (hits > 0) {
+        x = px + vx * (deltaTime - elapsed);
+        y = py + driftVy * (deltaTime - elapsed);
+        vy = driftVy + lag;
+    }
+    return hits;
+}
+
+size_t sweepFast(float* x, float* y, float* vx, float* vy, const float* radius,
+                 const float* scale, size_t count, const Params& params) {
+    size_t swept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!scale || scale[i] == 1.0f) {
+            if (isFast(vx[i], vy[i], radius[i], params.deltaTime)) {
+                sweep(x[i], y[i], vx[i], vy[i], radius[i], params);
+                ++swept;
+            }
+            continue;
+        }
+
+        // Balls that did not move this step are skipped; longer steps
+        // (multi-rate blocks) are swept over their own duration
+        Params scaled = params;
+        scaled.deltaTime = params.deltaTime * scale[i];
+        if (scaled.deltaTime > 0.0f && isFast(vx[i], vy[i], radius[i], scaled.deltaTime)) {
+            sweep(x[i], y[i], vx[i], vy[i], radius[i], scaled);
+            ++swept;
+        }
+    }
+    return swept;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ContainerKernel.h"
+#include "../entities/Container.h"
+#include <cstddef>
+
+// Continuous collision detection against the container wall.
+// The wall tests in ContainerKernel only look at where a ball ends the
+// step, so a ball that covers more than its wall band in one step (about
+// a diameter) passes through the thin shell. Balls that moved more than
+// CCD_DISPLACEMENT_RATIO of their radius are swept instead: the step is
+// replayed from its start position along the velocity it drifted at (a
+// straight line from start to end: the end velocity for semi-implicit
+// Euler, half a gravity kick less along y for the Verlet integrators) and
+// the first time of impact is found against
+//   - the arc, as the circles of radius R - r (from inside) and R + r
+//     (from outside), accepted if the contact direction is outside the
+//     gap at that moment, and
+//   - the two gap edges, as points moving with the rotating container
+//     (linearized over the step).
+// At an impact the ball is moved to the contact, its velocity reflected
+// with the same rule as the discrete wall response, and the rest of the
+// step is swept again, up to CCD_MAX_HITS times.
+namespace ContinuousCollision {
+    struct Params {
+        ContainerKernel::Params wall;  // Gap at the end of the step
+        float rotationRate;            // Gap angular speed, radians per second
+        float deltaTime;
+        float driftLag;                // The step drifted at vy - driftLag * h along y (h = its length)
+    };
+
+    // Container must already be rotated to the end of the step. driftLag
+    // is gravity / 2 after a Verlet integrator, 0 after semi-implicit Euler
+    // or a gravity-free drift.
+    Params makeParams(const Container& container, float restitution, float deltaTime, float driftLag = 0.0f);
+
+    // True if the ball moved far enough this step to be swept
+    bool isFast(float vx, float vy, float radius, float deltaTime);
+
+    // Replay the step of a ball that just moved to (x, y) with velocity
+    // (vx, vy); returns the number of wall hits
+    int sweep(float& x, float& y, float& vx, float& vy, float radius, const Params& params);
+
+    // Sweep the fast balls among [0, count); returns the number swept.
+    // With step scales, each ball moved for deltaTime * scale[i], ending
+    // with the step (nullptr = every ball moved for deltaTime)
+    size_t sweepFast(float* x, float* y, float* vx, float* vy, const float* radius,
+                     const float* scale, size_t count, const Params& params);
+}
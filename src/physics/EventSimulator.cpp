@@ -0,0 +1,437 @@
+#include "EventSimulator.h"
+#include "CollisionResolver.h"
+#include "../core/Config.h"
+#include "../math/MathUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+    inline void rotate(double x, double y, double angle, double& outX, double& outY) {
+        double c = std::cos(angle);
+        double s = std::sin(angle);
+        outX = x * c - y * s;
+        outY = x * s + y * c;
+    }
+}
+
+EventSimulator::EventSimulator()
+    : clock(0.0)
+    , stepEnd(0.0)
+    , eventCount(0)
+    , originX(0.0f)
+    , originY(0.0f)
+    , cellSize(1.0f)
+    , invCellSize(1.0f)
+    , gridWidth(0)
+    , gridHeight(0)
+    , visitStamp(0)
+    , wall()
+    , wallTime(0.0)
+    , rotationRate(0.0)
+{
+}
+
+void EventSimulator::advance(BallStore& balls, const Container& container, float deltaTime, float restitution) {
+    eventCount = 0;
+    stepEnd = clock + deltaTime;
+    wall = ContainerKernel::makeParams(container, restitution);
+    wallTime = stepEnd;
+    rotationRate = MathUtils::degToRad(container.getRotationSpeed());
+
+    beginStep(balls);
+
+    while (!queue.empty() && queue.front().time <= stepEnd) {
+        std::pop_heap(queue.begin(), queue.end(), Later());
+        Event event = queue.back();
+        queue.pop_back();
+
+        // Lazy invalidation: a ball has collided since this was predicted
+        if (collisionCount[event.a] != event.countA ||
+            (event.b != WALL && collisionCount[event.b] != event.countB)) {
+            continue;
+        }
+
+        // Contacts piling up at one instant (inelastic collapse): finish
+        // the step in straight lines
+        if (eventCount == static_cast<size_t>(Config::EVENT_MAX_PER_STEP)) {
+            break;
+        }
+
+        // The gap edge search stopped short of a contact: look again from there
+        if (event.kind == WallKind::Recheck) {
+            moveTo(balls, event.a, event.time);
+            predictWall(balls, event.a, event.time);
+            continue;
+        }
+
+        moveTo(balls, event.a, event.time);
+        if (event.b != WALL) {
+            moveTo(balls, event.b, event.time);
+        }
+        resolve(balls, event, restitution);
+        ++eventCount;
+
+        predict(balls, event.a, event.time);
+        if (event.b != WALL) {
+            predict(balls, event.b, event.time);
+        }
+    }
+
+    for (size_t i = 0; i < balls.size(); ++i) {
+        moveTo(balls, static_cast<uint32_t>(i), stepEnd);
+    }
+    clock = stepEnd;
+}
+
+void EventSimulator::beginStep(const BallStore& balls) {
+    const size_t count = balls.size();
+    queue.clear();
+    ballTime.assign(count, clock);
+    collisionCount.assign(count, 0);
+    visitMark.assign(count, visitStamp);
+
+    // Fit the grid to the swept boxes: cells at least a diameter wide, and
+    // no more cells than a few per ball
+    const double duration = stepEnd - clock;
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        float r = balls.radius[i];
+        float endX = static_cast<float>(balls.x[i] + balls.vx[i] * duration);
+        float endY = static_cast<float>(balls.y[i] + balls.vy[i] * duration);
+        float lowX = std::min(balls.x[i], endX) - r, highX = std::max(balls.x[i], endX) + r;
+        float lowY = std::min(balls.y[i], endY) - r, highY = std::max(balls.y[i], endY) + r;
+        minX = i == 0 ? lowX : std::min(minX, lowX);
+        minY = i == 0 ? lowY : std::min(minY, lowY);
+        maxX = i == 0 ? highX : std::max(maxX, highX);
+        maxY = i == 0 ? highY : std::max(maxY, highY);
+        maxRadius = std::max(maxRadius, r);
+    }
+    float width = maxX - minX;
+    float height = maxY - minY;
+    float maxCells = 4.0f * static_cast<float>(count) + 16.0f;
+    cellSize = std::max({2.0f * maxRadius, std::sqrt(width * height / maxCells), 1.0f});
+    invCellSize = 1.0f / cellSize;
+    originX = minX;
+    originY = minY;
+    gridWidth = static_cast<int>(width * invCellSize) + 1;
+    gridHeight = static_cast<int>(height * invCellSize) + 1;
+
+    size_t cellCount = static_cast<size_t>(gridWidth) * gridHeight;
+    if (cells.size() < cellCount) {
+        cells.resize(cellCount);
+    }
+    for (size_t c = 0; c < cellCount; ++c) {
+        cells[c].clear();
+    }
+
+    // Each ball is paired with the balls already in its cells, so every
+    // pair is predicted once
+    for (size_t i = 0; i < count; ++i) {
+        predict(balls, static_cast<uint32_t>(i), clock);
+    }
+}
+
+void EventSimulator::sweptCells(const BallStore& balls, uint32_t ball, double now,
+                                int& minX, int& minY, int& maxX, int& maxY) const {
+    const double elapsed = now - ballTime[ball];
+    const double r = balls.radius[ball];
+    const double startX = balls.x[ball] + balls.vx[ball] * elapsed;
+    const double startY = balls.y[ball] + balls.vy[ball] * elapsed;
+    const double endX = startX + balls.vx[ball] * (stepEnd - now);
+    const double endY = startY + balls.vy[ball] * (stepEnd - now);
+
+    // Clamped into the border cells: boxes that overlap still share a cell
+    auto cellOf = [this](double position, float origin, int size) {
+        double cell = std::floor((position - origin) * invCellSize);
+        return static_cast<int>(std::min(std::max(cell, 0.0), static_cast<double>(size - 1)));
+    };
+    minX = cellOf(std::min(startX, endX) - r, originX, gridWidth);
+    maxX = cellOf(std::max(startX, endX) + r, originX, gridWidth);
+    minY = cellOf(std::min(startY, endY) - r, originY, gridHeight);
+    maxY = cellOf(std::max(startY, endY) + r, originY, gridHeight);
+}
+
+void EventSimulator::moveTo(BallStore& balls, uint32_t ball, double time) {
+    double elapsed = time - ballTime[ball];
+    if (elapsed != 0.0) {
+        balls.x[ball] = static_cast<float>(balls.x[ball] + balls.vx[ball] * elapsed);
+        balls.y[ball] = static_cast<float>(balls.y[ball] + balls.vy[ball] * elapsed);
+        ballTime[ball] = time;
+    }
+}
+
+void EventSimulator::predict(const BallStore& balls, uint32_t ball, double now) {
+    predictWall(balls, ball, now);
+
+    // Against every ball listed in the cells of the new path, then list it there
+    int minX, minY, maxX, maxY;
+    sweptCells(balls, ball, now, minX, minY, maxX, maxY);
+    ++visitStamp;
+    visitMark[ball] = visitStamp;
+    for (int cy = minY; cy <= maxY; ++cy) {
+        for (int cx = minX; cx <= maxX; ++cx) {
+            std::vector<uint32_t>& cell = cells[static_cast<size_t>(cy) * gridWidth + cx];
+            for (uint32_t other : cell) {
+                if (visitMark[other] != visitStamp) {
+                    visitMark[other] = visitStamp;
+                    predictPair(balls, ball, other, now);
+                }
+            }
+            cell.push_back(ball);
+        }
+    }
+}
+
+void EventSimulator::predictPair(const BallStore& balls, uint32_t a, uint32_t b, double now) {
+    // Both balls at `now`
+    double ax = balls.x[a] + balls.vx[a] * (now - ballTime[a]);
+    double ay = balls.y[a] + balls.vy[a] * (now - ballTime[a]);
+    double bx = balls.x[b] + balls.vx[b] * (now - ballTime[b]);
+    double by = balls.y[b] + balls.vy[b] * (now - ballTime[b]);
+
+    double dx = bx - ax;
+    double dy = by - ay;
+    double dvx = static_cast<double>(balls.vx[b]) - balls.vx[a];
+    double dvy = static_cast<double>(balls.vy[b]) - balls.vy[a];
+    double approach = dx * dvx + dy * dvy;
+    if (approach >= 0.0) {
+        return;
+    }
+
+    // First root of |d + dv t| = r1 + r2; overlapping and approaching
+    // balls collide at once
+    double reach = static_cast<double>(balls.radius[a]) + balls.radius[b];
+    double c = dx * dx + dy * dy - reach * reach;
+    double t = 0.0;
+    if (c > 0.0) {
+        double speedSquared = dvx * dvx + dvy * dvy;
+        double discriminant = approach * approach - speedSquared * c;
+        if (discriminant < 0.0) {
+            return;
+        }
+        t = c / (-approach + std::sqrt(discriminant));
+    }
+    if (now + t > stepEnd) {
+        return;  // Predicted again next step
+    }
+    push(Event{now + t, a, b, collisionCount[a], collisionCount[b], WallKind::Inner});
+}
+
+void EventSimulator::predictWall(const BallStore& balls, uint32_t ball, double now) {
+    const double elapsed = now - ballTime[ball];
+    const double vx = balls.vx[ball];
+    const double vy = balls.vy[ball];
+    const double r = balls.radius[ball];
+    const double qx = balls.x[ball] + vx * elapsed - wall.centerX;
+    const double qy = balls.y[ball] + vy * elapsed - wall.centerY;
+    const double a = vx * vx + vy * vy;
+    if (a <= 0.0) {
+        return;
+    }
+    const double b = qx * vx + qy * vy;
+    const double distanceSquared = qx * qx + qy * qy;
+    const double radius = wall.radius;
+    const double inner = radius - r;
+    const double outer = radius + r;
+
+    double best = NEVER;
+    WallKind kind = WallKind::Inner;
+
+    // Arc from inside: leaving the circle of radius R - r. A ball in the
+    // inner band moving outwards is touching it already; one moving inwards
+    // (just bounced off it) crosses the disk first, or, on a path that never
+    // gets deeper than the band, turns outwards at its closest approach.
+    if (distanceSquared <= radius * radius) {
+        double t = 0.0;
+        if (inner > 0.0 && (distanceSquared < inner * inner || b <= 0.0)) {
+            double discriminant = b * b - a * (distanceSquared - inner * inner);
+            t = discriminant >= 0.0 ? (-b + std::sqrt(discriminant)) / a : -b / a;
+        }
+        if (!isInGapAt(qx + vx * t, qy + vy * t, now + t)) {
+            best = t;
+            kind = WallKind::Inner;
+        }
+    }
+
+    // Arc from outside: entering the circle of radius R + r
+    if (distanceSquared > radius * radius && b < 0.0) {
+        double t = 0.0;
+        bool reaches = true;
+        if (distanceSquared > outer * outer) {
+            double discriminant = b * b - a * (distanceSquared - outer * outer);
+            reaches = discriminant >= 0.0;
+            t = reaches ? (-b - std::sqrt(discriminant)) / a : 0.0;
+        }
+        if (reaches && t < best && !isInGapAt(qx + vx * t, qy + vy * t, now + t)) {
+            best = t;
+            kind = WallKind::Outer;
+        }
+    }
+
+    // Gap edges: only reachable while the center is within r of the rim,
+    // i.e. between the circles of radius R - r and R + r, and before any arc
+    // contact
+    double outerDisc = b * b - a * (distanceSquared - outer * outer);
+    if (wall.hasGap && outerDisc >= 0.0) {
+        double outerRoot = std::sqrt(outerDisc);
+        double bands[2][2] = {{(-b - outerRoot) / a, (-b + outerRoot) / a}, {NEVER, NEVER}};
+        double innerDisc = inner > 0.0 ? b * b - a * (distanceSquared - inner * inner) : -1.0;
+        if (innerDisc >= 0.0) {
+            double innerRoot = std::sqrt(innerDisc);
+            bands[1][0] = (-b + innerRoot) / a;
+            bands[1][1] = bands[0][1];
+            bands[0][1] = (-b - innerRoot) / a;
+        }
+
+        for (const auto& band : bands) {
+            double begin = std::max(band[0], 0.0);
+            double end = std::min({band[1], best, stepEnd - now});
+            if (!(begin < end)) {
+                continue;
+            }
+            for (WallKind edge : {WallKind::GapStart, WallKind::GapEnd}) {
+                double hit;
+                bool touching;
+                double px = qx + wall.centerX;
+                double py = qy + wall.centerY;
+                if (findEdgeContact(px, py, vx, vy, r, now, begin, end, edge, hit, touching) && hit < best) {
+                    best = hit;
+                    kind = touching ? edge : WallKind::Recheck;
+                }
+            }
+        }
+    }
+
+    if (now + best <= stepEnd) {
+        push(Event{now + best, ball, WALL, collisionCount[ball], 0, kind});
+    }
+}
+
+void EventSimulator::push(const Event& event) {
+    queue.push_back(event);
+    std::push_heap(queue.begin(), queue.end(), Later());
+}
+
+void EventSimulator::resolve(BallStore& balls, const Event& event, float restitution) {
+    const uint32_t a = event.a;
+    ++collisionCount[a];
+
+    if (event.b != WALL) {
+        const uint32_t b = event.b;
+        ++collisionCount[b];
+
+        float dx = balls.x[b] - balls.x[a];
+        float dy = balls.y[b] - balls.y[a];
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance <= 0.0f) {
+            return;
+        }
+        CollisionInfo info;
+        info.hasCollision = true;
+        info.normal = Vector2D(dx / distance, dy / distance);
+        CollisionResolver::resolveElasticCollision(balls, a, b, info, restitution);
+        return;
+    }
+
+    // Wall: same response as the discrete and swept tests, relative to the
+    // wall (gap edges move)
+    double normalX, normalY;
+    double wallVx = 0.0;
+    double wallVy = 0.0;
+    double qx = balls.x[a] - wall.centerX;
+    double qy = balls.y[a] - wall.centerY;
+    if (event.kind == WallKind::Inner || event.kind == WallKind::Outer) {
+        double length = std::sqrt(qx * qx + qy * qy);
+        if (length <= 0.0) {
+            return;
+        }
+        double sign = event.kind == WallKind::Inner ? 1.0 : -1.0;
+        normalX = sign * qx / length;
+        normalY = sign * qy / length;
+    } else {
+        double edgeX, edgeY;
+        edgeAt(event.kind, event.time, edgeX, edgeY);
+        double nx = edgeX - balls.x[a];
+        double ny = edgeY - balls.y[a];
+        double length = std::sqrt(nx * nx + ny * ny);
+        if (length <= 0.0) {
+            return;
+        }
+        normalX = nx / length;
+        normalY = ny / length;
+        wallVx = -rotationRate * (edgeY - wall.centerY);
+        wallVy = rotationRate * (edgeX - wall.centerX);
+    }
+
+    double velocityAlongNormal = (balls.vx[a] - wallVx) * normalX + (balls.vy[a] - wallVy) * normalY;
+    if (velocityAlongNormal > 0.0) {
+        double impulse = 2.0 * velocityAlongNormal * restitution;
+        balls.vx[a] = static_cast<float>(balls.vx[a] - normalX * impulse);
+        balls.vy[a] = static_cast<float>(balls.vy[a] - normalY * impulse);
+    }
+}
+
+bool EventSimulator::isInGapAt(double dx, double dy, double time) const {
+    if (!wall.hasGap) {
+        return false;
+    }
+    // The gap was rotationRate * (wallTime - time) behind where `wall` has
+    // it, so turn the direction forward instead
+    double rx, ry;
+    rotate(dx, dy, rotationRate * (wallTime - time), rx, ry);
+    return ContainerKernel::isInGap(static_cast<float>(rx), static_cast<float>(ry), wall);
+}
+
+void EventSimulator::edgeAt(WallKind kind, double time, double& x, double& y) const {
+    double directionX = kind == WallKind::GapStart ? wall.gapStartX : wall.gapEndX;
+    double directionY = kind == WallKind::GapStart ? wall.gapStartY : wall.gapEndY;
+    rotate(directionX, directionY, -rotationRate * (wallTime - time), x, y);
+    x = wall.centerX + wall.radius * x;
+    y = wall.centerY + wall.radius * y;
+}
+
+bool EventSimulator::findEdgeContact(double px, double py, double vx, double vy, double r, double now,
+                                     double begin, double end, WallKind kind, double& hit, bool& touching) const {
+    // Distance from the ball's surface to the rotating edge point, `t` after `now`
+    auto gap = [&](double t) {
+        double edgeX, edgeY;
+        edgeAt(kind, now + t, edgeX, edgeY);
+        double dx = px + vx * t - edgeX;
+        double dy = py + vy * t - edgeY;
+        return std::sqrt(dx * dx + dy * dy) - r;
+    };
+
+    // Conservative advancement: neither the ball nor the edge point moves
+    // faster than this, so the gap cannot close before gap / closingBound
+    const double closingBound = std::sqrt(vx * vx + vy * vy) + std::abs(rotationRate) * wall.radius;
+    const double tolerance = Config::EVENT_EDGE_TOLERANCE * r;
+    const double nudge = tolerance / closingBound;
+
+    double t = begin;
+    for (int k = 0; k < Config::EVENT_EDGE_MAX_STEPS; ++k) {
+        double current = gap(t);
+        double step = current / closingBound;
+        if (current <= tolerance) {
+            // Within reach: a contact only if closing in, else slide past
+            if (gap(t + 1e-3 * nudge) < current) {
+                hit = t;
+                touching = true;
+                return true;
+            }
+            step = nudge;
+        }
+        t += step;
+        if (t >= end) {
+            return false;
+        }
+    }
+
+    // Out of steps (a slow, nearly tangent pass): continue from here later
+    hit = t;
+    touching = false;
+    return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../entities/Container.h"
+#include "ContainerKernel.h"
+#include <cstdint>
+#include <vector>
+
+// Event-driven simulation for gravity-free scenes.
+// Without gravity balls move in straight lines between collisions, so
+// instead of stepping, every ball-ball and ball-wall contact within the
+// step is predicted exactly and kept in a priority queue by time. advance()
+// pops events in order up to the end of the step, moves the two balls
+// involved to the event time, resolves the contact with the usual
+// responses and predicts new events for them. Only the balls in an event
+// are touched; the rest are brought to the end of the step once.
+//
+// Pairs are only predicted between balls that share a cell of a uniform
+// grid, built each step from the box each ball sweeps until the end of the
+// step. A ball whose path changes adds the cells of its new box, so every
+// cell lists all balls that may pass through it and a prediction costs the
+// balls nearby rather than all of them. Contacts after the end of the step
+// are left for the next step, which predicts everything afresh.
+//
+// Every ball counts its collisions. An event remembers the counts of its
+// balls when it was predicted and is dropped when popped if either has
+// changed since (lazy invalidation), so nothing is ever removed from the
+// middle of the queue.
+//
+// Wall contacts follow ContinuousCollision: the arc is the circle of
+// radius R - r from inside and R + r from outside, accepted if the contact
+// direction is outside the gap at that moment (the gap's rotation is
+// exact, from the container's constant rotation speed). While a ball
+// passes through the gap band, the two gap edges are searched as rotating
+// points by conservative advancement (each step is the distance over the
+// largest closing speed, so no contact is skipped). The search takes at
+// most EVENT_EDGE_MAX_STEPS steps; a slow, nearly tangent pass that needs
+// more schedules a recheck event where it stopped.
+class EventSimulator {
+public:
+    EventSimulator();
+
+    // Move the scene forward by deltaTime. The container must already be
+    // rotated to the end of the step.
+    void advance(BallStore& balls, const Container& container, float deltaTime, float restitution);
+
+    size_t getEventCount() const { return eventCount; }  // Contacts resolved by the last advance()
+    size_t getQueueSize() const { return queue.size(); }
+
+private:
+    static constexpr uint32_t WALL = 0xFFFFFFFFu;  // Partner of a wall event
+
+    enum class WallKind : uint8_t {
+        Inner, Outer, GapStart, GapEnd,
+        Recheck   // No contact: the gap edge search ran out of steps here
+    };
+
+    struct Event {
+        double time;
+        uint32_t a, b;               // b = WALL for wall events
+        uint32_t countA, countB;     // Collision counts at prediction (countB unused for walls)
+        WallKind kind;
+    };
+
+    // Min-heap by time
+    struct Later {
+        bool operator()(const Event& lhs, const Event& rhs) const { return lhs.time > rhs.time; }
+    };
+
+    double clock;                      // Simulation time at the end of the last advance()
+    double stepEnd;                    // End of the current step: the prediction horizon
+    std::vector<Event> queue;
+    std::vector<double> ballTime;      // Time each ball's row was last brought up to
+    std::vector<uint32_t> collisionCount;
+    size_t eventCount;
+
+    // Swept-box grid of the current step. Cells only grow during a step;
+    // stale entries (balls that changed course since) are harmless.
+    float originX, originY;
+    float cellSize, invCellSize;
+    int gridWidth, gridHeight;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> visitMark;   // Last prediction that checked each ball
+    uint32_t visitStamp;
+
+    ContainerKernel::Params wall;      // At the end of the current step
+    double wallTime;                   // Time `wall` describes
+    double rotationRate;               // Radians per second
+
+    void beginStep(const BallStore& balls);
+    void sweptCells(const BallStore& balls, uint32_t ball, double now, int& minX, int& minY, int& maxX, int& maxY) const;
+    void moveTo(BallStore& balls, uint32_t ball, double time);
+    void predict(const BallStore& balls, uint32_t ball, double now);
+    void predictPair(const BallStore& balls, uint32_t a, uint32_t b, double now);
+    void predictWall(const BallStore& balls, uint32_t ball, double now);
+    void push(const Event& event);
+    void resolve(BallStore& balls, const Event& event, float restitution);
+
+    // Wall geometry at absolute time `time`
+    bool isInGapAt(double dx, double dy, double time) const;
+    void edgeAt(WallKind kind, double time, double& x, double& y) const;
+    // First contact with a gap edge in [begin, end) after `now`. touching is
+    // false if the search stopped early at `hit` without one.
+    bool findEdgeContact(double px, double py, double vx, double vy, double r, double now,
+                         double begin, double end, WallKind kind, double& hit, bool& touching) const;
+};
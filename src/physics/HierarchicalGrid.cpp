@@ -0,0 +1,109 @@
+#include "HierarchicalGrid.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <cmath>
+
+HierarchicalGrid::HierarchicalGrid(float baseCellSize, float worldWidth, float worldHeight)
+    : originX(0.0f)
+    , originY(0.0f)
+    , worldWidth(0.0f)
+    , worldHeight(0.0f)
+    , baseCellSize(0.0f)
+    , invBaseCellSize(0.0f)
+    , baseWidth(0)
+    , baseHeight(0)
+{
+    configure(0.0f, 0.0f, worldWidth, worldHeight, baseCellSize, 1);
+}
+
+void HierarchicalGrid::configure(float newOriginX, float newOriginY, float newWorldWidth, float newWorldHeight,
+                                 float newBaseCellSize, int levelCount) {
+    levelCount = std::max(1, std::min(levelCount, Config::HGRID_MAX_LEVELS));
+    if (newOriginX == originX && newOriginY == originY &&
+        newWorldWidth == worldWidth && newWorldHeight == worldHeight &&
+        newBaseCellSize == baseCellSize && levelCount == getLevelCount()) {
+        return;
+    }
+
+    originX = newOriginX;
+    originY = newOriginY;
+    worldWidth = newWorldWidth;
+    worldHeight = newWorldHeight;
+    baseCellSize = newBaseCellSize;
+    invBaseCellSize = 1.0f / newBaseCellSize;
+    baseWidth = std::max(1, static_cast<int>(std::ceil(worldWidth / baseCellSize)));
+    baseHeight = std::max(1, static_cast<int>(std::ceil(worldHeight / baseCellSize)));
+
+    // Level l halves the resolution of level l - 1, rounding up so the
+    // shifted level-0 coordinates always land inside it
+    levels.resize(levelCount);
+    uint32_t firstCell = 0;
+    for (int l = 0; l < levelCount; ++l) {
+        Level& level = levels[l];
+        level.width = ((baseWidth - 1) >> l) + 1;
+        level.height = ((baseHeight - 1) >> l) + 1;
+        level.firstCell = firstCell;
+        level.ballCount = 0;
+        firstCell += static_cast<uint32_t>(level.width * level.height);
+    }
+    cellStart.resize(firstCell + 1);
+}
+
+void HierarchicalGrid::build(const BallStore& balls, JobSystem* jobs) {
+    const size_t count = balls.size();
+    const size_t cellCount = cellStart.size() - 1;
+    const int levelCount = getLevelCount();
+    ballCell.resize(count);
+    cellBalls.resize(count);
+
+    // Pass 1: level and flat cell of every ball (independent per ball)
+    auto assign = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            // Finest level whose cells fit the ball's diameter
+            const float diameter = 2.0f * balls.radius[i];
+            int l = 0;
+            float size = baseCellSize;
+            while (size < diameter && l + 1 < levelCount) {
+                size *= 2.0f;
+                ++l;
+            }
+
+            // Clamp in float space, like SpatialGrid
+            float fx = std::floor((balls.x[i] - originX) * invBaseCellSize);
+            float fy = std::floor((balls.y[i] - originY) * invBaseCellSize);
+            int cx = static_cast<int>(std::min(std::max(fx, 0.0f), static_cast<float>(baseWidth - 1))) >> l;
+            int cy = static_cast<int>(std::min(std::max(fy, 0.0f), static_cast<float>(baseHeight - 1))) >> l;
+
+            const Level& level = levels[l];
+            ballCell[i] = level.firstCell + static_cast<uint32_t>(cy * level.width + cx);
+        }
+    };
+
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, assign);
+    } else {
+        assign(0, count);
+    }
+
+    // Pass 2: counting sort by flat cell
+    std::fill(cellStart.begin(), cellStart.end(), 0u);
+    for (size_t i = 0; i < count; ++i) {
+        ++cellStart[ballCell[i] + 1];
+    }
+    for (size_t c = 0; c < cellCount; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    for (int l = 0; l < levelCount; ++l) {
+        uint32_t end = l + 1 < levelCount ? levels[l + 1].firstCell : static_cast<uint32_t>(cellCount);
+        levels[l].ballCount = cellStart[end] - cellStart[levels[l].firstCell];
+    }
+
+    // Scatter, using cellStart as the cursors and shifting it back after
+    for (size_t i = 0; i < count; ++i) {
+        cellBalls[cellStart[ballCell[i]]++] = static_cast<uint32_t>(i);
+    }
+    for (size_t c = cellCount; c > 0; --c) {
+        cellStart[c] = cellStart[c - 1];
+    }
+    cellStart[0] = 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
+#include <vector>
+
+// Hierarchical uniform grid for populations with mixed ball sizes.
+// Level l has cells of baseCellSize * 2^l over the same extents, and every
+// ball is stored once, in the finest level whose cells are at least its
+// diameter. A ball is checked against its own level with the usual
+// half-neighbourhood stencil and against the 3 x 3 block around its cell in
+// each coarser level; coarse balls never look down, so every pair is seen
+// once. Small balls no longer pay for cells sized to the largest ball.
+//
+// All levels share one flat counting-sort layout: level l owns the cell
+// range [firstCell, firstCell + width * height) of cellStart. Level cell
+// coordinates are the level-0 coordinates shifted right by l, so a fine
+// cell maps to its coarse cell without touching ball positions.
+class HierarchicalGrid {
+public:
+    HierarchicalGrid(float baseCellSize, float worldWidth, float worldHeight);
+
+    // Cover [originX, originX + worldWidth) x [originY, originY + worldHeight)
+    // with levelCount levels, the finest with cells of baseCellSize.
+    // Does nothing if the layout is unchanged.
+    void configure(float originX, float originY, float worldWidth, float worldHeight,
+                   float baseCellSize, int levelCount);
+
+    // Assign balls to levels and cells (counting sort over all levels)
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every potential collision pair
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+    float getBaseCellSize() const { return baseCellSize; }
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+private:
+    struct Level {
+        int width, height;
+        uint32_t firstCell;  // First slot of this level in cellStart
+        uint32_t ballCount;  // Balls stored in this level (last build)
+    };
+
+    float originX, originY;
+    float worldWidth, worldHeight;
+    float baseCellSize;
+    float invBaseCellSize;
+    int baseWidth, baseHeight;
+    std::vector<Level> levels;
+
+    std::vector<uint32_t> cellStart;  // totalCells + 1 offsets
+    std::vector<uint32_t> cellBalls;  // Ball indices sorted by (level, cell)
+    std::vector<uint32_t> ballCell;   // Flat cell of each ball
+
+    // All pairs between the balls in [begin, end) and the balls of one cell
+    template <typename Visitor>
+    void visitAgainstCell(uint32_t begin, uint32_t end, uint32_t cell, Visitor& visit) const;
+};
+
+template <typename Visitor>
+void HierarchicalGrid::visitAgainstCell(uint32_t begin, uint32_t end, uint32_t cell, Visitor& visit) const {
+    const uint32_t otherBegin = cellStart[cell];
+    const uint32_t otherEnd = cellStart[cell + 1];
+    for (uint32_t i = begin; i < end; ++i) {
+        for (uint32_t j = otherBegin; j < otherEnd; ++j) {
+            visit(cellBalls[i], cellBalls[j]);
+        }
+    }
+}
+
+template <typename Visitor>
+void HierarchicalGrid::forEachPotentialCollision(Visitor&& visit) const {
+    const int levelCount = static_cast<int>(levels.size());
+    for (int l = 0; l < levelCount; ++l) {
+        const Level& level = levels[l];
+        if (level.ballCount == 0) {
+            continue;
+        }
+
+        for (int cy = 0; cy < level.height; ++cy) {
+            for (int cx = 0; cx < level.width; ++cx) {
+                const uint32_t cell = level.firstCell + static_cast<uint32_t>(cy * level.width + cx);
+                const uint32_t begin = cellStart[cell];
+                const uint32_t end = cellStart[cell + 1];
+                if (begin == end) {
+                    continue;
+                }
+
+                // Same level: within the cell, then right, down, down-right
+                // and down-left (as SpatialGrid)
+                for (uint32_t i = begin; i < end; ++i) {
+                    for (uint32_t j = i + 1; j < end; ++j) {
+                        visit(cellBalls[i], cellBalls[j]);
+                    }
+                }
+                const int dx[] = {1, 0, 1, -1};
+                const int dy[] = {0, 1, 1, 1};
+                for (int d = 0; d < 4; ++d) {
+                    int nx = cx + dx[d];
+                    int ny = cy + dy[d];
+                    if (nx < 0 || nx >= level.width || ny >= level.height) {
+                        continue;
+                    }
+                    visitAgainstCell(begin, end, level.firstCell + static_cast<uint32_t>(ny * level.width + nx), visit);
+                }
+
+                // Coarser levels: every ball there is at most one coarse cell
+                // away, since both diameters fit in a coarse cell
+                for (int L = l + 1; L < levelCount; ++L) {
+                    const Level& coarse = levels[L];
+                    if (coarse.ballCount == 0) {
+                        continue;
+                    }
+                    const int shift = L - l;
+                    const int pcx = cx >> shift;
+                    const int pcy = cy >> shift;
+                    for (int ny = pcy - 1; ny <= pcy + 1; ++ny) {
+                        if (ny < 0 || ny >= coarse.height) {
+                            continue;
+                        }
+                        for (int nx = pcx - 1; nx <= pcx + 1; ++nx) {
+                            if (nx < 0 || nx >= coarse.width) {
+                                continue;
+                            }
+                            visitAgainstCell(begin, end, coarse.firstCell + static_cast<uint32_t>(ny * coarse.width + nx), visit);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
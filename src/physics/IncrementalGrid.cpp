@@ -0,0 +1,177 @@
+#include "IncrementalGrid.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <cmath>
+
+IncrementalGrid::IncrementalGrid(float cellSize, float worldWidth, float worldHeight)
+    : originX(0.0f)
+    , originY(0.0f)
+    , worldWidth(0.0f)
+    , worldHeight(0.0f)
+    , cellSize(0.0f)
+    , invCellSize(0.0f)
+    , gridWidth(0)
+    , gridHeight(0)
+    , layoutVersion(0)
+    , needsRebuild(true)
+    , movedCount(0)
+{
+    configure(0.0f, 0.0f, worldWidth, worldHeight, cellSize);
+}
+
+void IncrementalGrid::configure(float newOriginX, float newOriginY, float newWorldWidth, float newWorldHeight, float newCellSize) {
+    if (newOriginX == originX && newOriginY == originY &&
+        newWorldWidth == worldWidth && newWorldHeight == worldHeight &&
+        newCellSize == cellSize) {
+        return;
+    }
+
+    originX = newOriginX;
+    originY = newOriginY;
+    worldWidth = newWorldWidth;
+    worldHeight = newWorldHeight;
+    cellSize = newCellSize;
+    invCellSize = 1.0f / newCellSize;
+
+    gridWidth = std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)));
+    gridHeight = std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)));
+    cells.resize(static_cast<size_t>(gridWidth) * gridHeight);
+    cellDirty.assign(cells.size(), 0);
+    dirtyCells.clear();
+    needsRebuild = true;
+}
+
+void IncrementalGrid::build(const BallStore& balls, JobSystem* jobs) {
+    if (needsRebuild || !followLayout(balls)) {
+        clearCells();
+        ballCell.clear();
+        layoutVersion = balls.getLayoutVersion();
+        needsRebuild = false;
+    }
+
+    // Unbinned rows (spawns, first build) get NO_CELL and are inserted below
+    const size_t count = balls.size();
+    ballCell.resize(count, NO_CELL);
+    ballSlot.resize(count);
+    targetCell.resize(count);
+
+    // Cells for the current positions, independent per ball
+    auto locate = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            targetCell[i] = static_cast<uint32_t>(getCellY(balls.y[i]) * gridWidth + getCellX(balls.x[i]));
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, locate);
+    } else {
+        locate(0, count);
+    }
+
+    // Re-bin only the balls that crossed a cell border
+    movedCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t target = targetCell[i];
+        if (ballCell[i] == target) {
+            continue;
+        }
+
+        const uint32_t ball = static_cast<uint32_t>(i);
+        if (ballCell[i] != NO_CELL) {
+            removeFromCell(ball);
+        }
+        std::vector<uint32_t>& bucket = cells[target];
+        ballCell[i] = target;
+        ballSlot[i] = static_cast<uint32_t>(bucket.size());
+        bucket.push_back(ball);
+        ++movedCount;
+    }
+
+    compactDirtyCells();
+}
+
+bool IncrementalGrid::followLayout(const BallStore& balls) {
+    const uint64_t version = balls.getLayoutVersion();
+    if (version == layoutVersion) {
+        return true;
+    }
+    if (version != layoutVersion + 1) {
+        return false;
+    }
+
+    // Renumber every stored ball; removed ones leave holes. Rows the grid
+    // has not binned yet stay NO_CELL and are inserted by build().
+    const std::vector<uint32_t>& remap = balls.getLastRemap();
+    const size_t knownCount = ballCell.size();
+    if (knownCount > remap.size()) {
+        return false;
+    }
+
+    targetCell.assign(balls.size(), NO_CELL);  // New ballCell
+    slotScratch.resize(balls.size());          // New ballSlot
+    for (size_t old = 0; old < knownCount; ++old) {
+        const uint32_t cell = ballCell[old];
+        if (cell == NO_CELL) {
+            continue;
+        }
+
+        const uint32_t mapped = remap[old];
+        if (mapped == BallStore::REMOVED) {
+            removeFromCell(static_cast<uint32_t>(old));
+            continue;
+        }
+        cells[cell][ballSlot[old]] = mapped;
+        targetCell[mapped] = cell;
+        slotScratch[mapped] = ballSlot[old];
+    }
+
+    ballCell.swap(targetCell);
+    ballSlot.swap(slotScratch);
+    layoutVersion = version;
+    return true;
+}
+
+void IncrementalGrid::clearCells() {
+    for (std::vector<uint32_t>& bucket : cells) {
+        bucket.clear();
+    }
+    std::fill(cellDirty.begin(), cellDirty.end(), 0);
+    dirtyCells.clear();
+}
+
+void IncrementalGrid::removeFromCell(uint32_t ball) {
+    // Leave a hole; the bucket is compacted at the end of the build
+    const uint32_t cell = ballCell[ball];
+    cells[cell][ballSlot[ball]] = HOLE;
+    if (!cellDirty[cell]) {
+        cellDirty[cell] = 1;
+        dirtyCells.push_back(cell);
+    }
+}
+
+void IncrementalGrid::compactDirtyCells() {
+    for (uint32_t cell : dirtyCells) {
+        std::vector<uint32_t>& bucket = cells[cell];
+        size_t write = 0;
+        for (uint32_t ball : bucket) {
+            if (ball == HOLE) {
+                continue;
+            }
+            ballSlot[ball] = static_cast<uint32_t>(write);
+            bucket[write++] = ball;
+        }
+        bucket.resize(write);
+        cellDirty[cell] = 0;
+    }
+    dirtyCells.clear();
+}
+
+int IncrementalGrid::getCellX(float x) const {
+    // Clamp in float space so far-away positions cannot overflow the cast
+    float cx = std::floor((x - originX) * invCellSize);
+    return static_cast<int>(std::min(std::max(cx, 0.0f), static_cast<float>(gridWidth - 1)));
+}
+
+int IncrementalGrid::getCellY(float y) const {
+    float cy = std::floor((y - originY) * invCellSize);
+    return static_cast<int>(std::min(std::max(cy, 0.0f), static_cast<float>(gridHeight - 1)));
+}
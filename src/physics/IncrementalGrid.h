@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
+#include <vector>
+
+// Uniform grid that is updated instead of rebuilt.
+// Every ball remembers its cell and its slot in that cell's bucket. Each
+// build recomputes the cells in parallel, then only balls whose cell
+// changed leave their old bucket (the slot becomes a hole) and append to
+// the new one. Buckets with holes are compacted once at the end of the
+// build, so the cell walk never sees a hole and the serial work follows
+// the number of balls that crossed a cell border rather than the
+// population. Buckets keep their capacity between steps.
+//
+// Culling renumbers the stored indices through the BallStore layout remap;
+// a change of cell size or extents rebuilds from scratch.
+class IncrementalGrid {
+public:
+    IncrementalGrid(float cellSize, float worldWidth, float worldHeight);
+
+    // Same contract as SpatialGrid::configure; a changed layout re-bins
+    // every ball on the next build
+    void configure(float originX, float originY, float worldWidth, float worldHeight, float cellSize);
+
+    // Move the balls whose cell changed since the last build
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every potential collision pair (same stencil as
+    // SpatialGrid)
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+    float getCellSize() const { return cellSize; }
+    size_t getMovedCount() const { return movedCount; }  // Balls re-binned by the last build
+
+private:
+    static constexpr uint32_t NO_CELL = 0xFFFFFFFFu;
+    static constexpr uint32_t HOLE = 0xFFFFFFFFu;
+
+    float originX, originY;
+    float worldWidth, worldHeight;
+    float cellSize;
+    float invCellSize;
+    int gridWidth, gridHeight;
+
+    std::vector<std::vector<uint32_t>> cells;  // Ball indices per cell
+    std::vector<uint32_t> ballCell;            // Current cell of each ball (NO_CELL = not binned)
+    std::vector<uint32_t> ballSlot;            // Index of each ball inside its cell
+    std::vector<uint32_t> targetCell;          // Cell for this step's positions (scratch)
+    std::vector<uint32_t> slotScratch;
+    std::vector<uint32_t> dirtyCells;          // Cells with holes
+    std::vector<uint8_t> cellDirty;
+
+    uint64_t layoutVersion;
+    bool needsRebuild;
+    size_t movedCount;
+
+    bool followLayout(const BallStore& balls);
+    void clearCells();
+    void removeFromCell(uint32_t ball);
+    void compactDirtyCells();
+    int getCellX(float x) const;
+    int getCellY(float y) const;
+};
+
+template <typename Visitor>
+void IncrementalGrid::forEachPotentialCollision(Visitor&& visit) const {
+    const int dx[] = {1, 0, 1, -1};
+    const int dy[] = {0, 1, 1, 1};
+
+    for (int cy = 0; cy < gridHeight; ++cy) {
+        for (int cx = 0; cx < gridWidth; ++cx) {
+            const std::vector<uint32_t>& bucket = cells[cy * gridWidth + cx];
+            const size_t count = bucket.size();
+            if (count == 0) {
+                continue;
+            }
+
+            // Within the same cell
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t j = i + 1; j < count; ++j) {
+                    visit(bucket[i], bucket[j]);
+                }
+            }
+
+            // Adjacent cells (right, down, down-right, down-left)
+            for (int d = 0; d < 4; ++d) {
+                int nx = cx + dx[d];
+                int ny = cy + dy[d];
+                if (nx < 0 || nx >= gridWidth || ny >= gridHeight) {
+                    continue;
+                }
+
+                const std::vector<uint32_t>& neighbor = cells[ny * gridWidth + nx];
+                for (uint32_t a : bucket) {
+                    for (uint32_t b : neighbor) {
+                        visit(a, b);
+                    }
+                }
+            }
+        }
+    }
+}
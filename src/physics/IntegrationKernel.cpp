@@ -0,0 +1,129 @@
+#include "IntegrationKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace IntegrationKernel {
+
+namespace {
+    // A group of SIMD lanes with the two operations the policies use
+#if defined(__AVX2__)
+#define INTEGRATION_HAS_LANES 1
+    struct Lanes {
+        static constexpr size_t WIDTH = 8;
+        __m256 v;
+        Lanes(__m256 v) : v(v) {}
+        Lanes(float s) : v(_mm256_set1_ps(s)) {}
+        static Lanes load(const float* p) { return Lanes(_mm256_loadu_ps(p)); }
+        void store(float* p) const { _mm256_storeu_ps(p, v); }
+    };
+    inline Lanes operator+(Lanes a, Lanes b) { return Lanes(_mm256_add_ps(a.v, b.v)); }
+    inline Lanes operator*(Lanes a, Lanes b) { return Lanes(_mm256_mul_ps(a.v, b.v)); }
+#elif defined(__SSE2__) || defined(_M_X64)
+#define INTEGRATION_HAS_LANES 1
+    struct Lanes {
+        static constexpr size_t WIDTH = 4;
+        __m128 v;
+        Lanes(__m128 v) : v(v) {}
+        Lanes(float s) : v(_mm_set1_ps(s)) {}
+        static Lanes load(const float* p) { return Lanes(_mm_loadu_ps(p)); }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+    };
+    inline Lanes operator+(Lanes a, Lanes b) { return Lanes(_mm_add_ps(a.v, b.v)); }
+    inline Lanes operator*(Lanes a, Lanes b) { return Lanes(_mm_mul_ps(a.v, b.v)); }
+#endif
+
+    template <typename Policy, bool ZeroGravity, bool Scaled>
+    void runScalar(float* x, float* y, const float* vx, float* vy, const float* scale,
+                   size_t count, float gravity, float deltaTime) {
+        for (size_t i = 0; i < count; ++i) {
+            float h = deltaTime;
+            if constexpr (Scaled) {
+                h = deltaTime * scale[i];
+            }
+            Policy::template step<ZeroGravity>(x[i], y[i], vx[i], vy[i], gravity, h);
+        }
+    }
+
+    template <typename Policy, bool ZeroGravity, bool Scaled>
+    void run(float* x, float* y, const float* vx, float* vy, const float* scale,
+             size_t count, float gravity, float deltaTime) {
+        size_t i = 0;
+
+#if defined(INTEGRATION_HAS_LANES)
+        const Lanes g(gravity);
+        const Lanes dt(deltaTime);
+        for (; i + Lanes::WIDTH <= count; i += Lanes::WIDTH) {
+            Lanes h = dt;
+            if constexpr (Scaled) {
+                h = dt * Lanes::load(scale + i);
+            }
+            Lanes posX = Lanes::load(x + i);
+            Lanes posY = Lanes::load(y + i);
+            Lanes velY = Lanes::load(vy + i);
+            Policy::template step<ZeroGravity>(posX, posY, Lanes::load(vx + i), velY, g, h);
+            velY.store(vy + i);
+            posX.store(x + i);
+            posY.store(y + i);
+        }
+#endif
+
+        // Scalar tail
+        runScalar<Policy, ZeroGravity, Scaled>(x + i, y + i, vx + i, vy + i, Scaled ? scale + i : scale,
+                                               count - i, gravity, deltaTime);
+    }
+
+    template <typename Policy>
+    Function selectFor(bool zeroGravity, bool scaled) {
+        if (zeroGravity) {
+            return scaled ? run<Policy, true, true> : run<Policy, true, false>;
+        }
+        return scaled ? run<Policy, false, true> : run<Policy, false, false>;
+    }
+}
+
+Function select(IntegratorType type, bool zeroGravity, bool scaled) {
+    // Without gravity every integrator is the same drift
+    if (zeroGravity) {
+        type = IntegratorType::SemiImplicitEuler;
+    }
+    switch (type) {
+        case IntegratorType::VelocityVerlet:
+            return selectFor<Integrator::VelocityVerlet>(zeroGravity, scaled);
+        case IntegratorType::PositionVerlet:
+            return selectFor<Integrator::PositionVerlet>(zeroGravity, scaled);
+        case IntegratorType::SemiImplicitEuler:
+        default:
+            return selectFor<Integrator::SemiImplicitEuler>(zeroGravity, scaled);
+    }
+}
+
+void integrateScalar(float* x, float* y, const float* vx, float* vy,
+                     size_t count, float gravity, float deltaTime) {
+    runScalar<Integrator::SemiImplicitEuler, false, false>(x, y, vx, vy, nullptr, count, gravity, deltaTime);
+}
+
+void integrate(float* x, float* y, const float* vx, float* vy,
+               size_t count, float gravity, float deltaTime) {
+    run<Integrator::SemiImplicitEuler, false, false>(x, y, vx, vy, nullptr, count, gravity, deltaTime);
+}
+
+void integrateScaled(float* x, float* y, const float* vx, float* vy, const float* scale,
+                     size_t count, float gravity, float deltaTime) {
+    run<Integrator::SemiImplicitEuler, false, true>(x, y, vx, vy, scale, count, gravity, deltaTime);
+}
+
+const char* getInstructionSet() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+}
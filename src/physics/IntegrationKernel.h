@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Integrator.h"
+#include <cstddef>
+
+// Vectorized integration over the BallStore columns.
+// The SIMD width is picked at compile time: AVX2 (8 lanes) when the build
+// enables it, SSE2 (4 lanes) on any x86-64 target, scalar elsewhere. Every
+// path performs the same multiply/add sequence per ball, so results are
+// bitwise identical to the scalar loop of the same integrator.
+//
+// Each integrator policy (see Integrator.h) is instantiated with and
+// without gravity and with and without per-ball step scales, so the inner
+// loops carry no branches; select() picks the instantiation for a step.
+namespace IntegrationKernel {
+    // Kernel signature shared by every instantiation. scale is only read by
+    // the scaled kernels (h = dt * scale[i]; 0 freezes the ball, 1 matches
+    // the unscaled kernel bitwise).
+    using Function = void (*)(float* x, float* y, const float* vx, float* vy, const float* scale,
+                              size_t count, float gravity, float deltaTime);
+
+    // Kernel for an integrator, gravity == 0 and per-ball scaling
+    Function select(IntegratorType type, bool zeroGravity, bool scaled);
+
+    // Fused semi-implicit Euler step:
+    //   vy += gravity * dt;  x += vx * dt;  y += vy * dt
+    void integrate(float* x, float* y, const float* vx, float* vy,
+                   size_t count, float gravity, float deltaTime);
+
+    // Reference scalar implementation of integrate()
+    void integrateScalar(float* x, float* y, const float* vx, float* vy,
+                         size_t count, float gravity, float deltaTime);
+
+    // Same step with a per-ball time scale
+    void integrateScaled(float* x, float* y, const float* vx, float* vy, const float* scale,
+                         size_t count, float gravity, float deltaTime);
+
+    // Name of the instruction set integrate() was compiled for
+    const char* getInstructionSet();
+}
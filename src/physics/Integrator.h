@@ -0,0 +1,61 @@
+#pragma once
+
+// How the pairwise solver advances balls under gravity each step. Picked at
+// startup (see SimulationOptions) or with PhysicsEngine::setIntegrator. The
+// impulse and position-based solvers fold gravity into their own velocity
+// passes and always step semi-implicitly.
+enum class IntegratorType {
+    SemiImplicitEuler,  // Kick then drift
+    VelocityVerlet,     // Half kick, drift, half kick
+    PositionVerlet      // Half drift, kick, half drift
+};
+
+// Integrator policies. step() advances one ball (or one SIMD lane group:
+// V is float or a lane type with + and *) by h under gravity g along y.
+// With ZeroGravity every policy compiles down to the same drift.
+//
+// Gravity is the only force and it is uniform, so both Verlet schemes move
+// by v*h + g*h²/2 where semi-implicit Euler moves by v*h + g*h²; the Verlet
+// variants differ from each other only in rounding.
+namespace Integrator {
+    struct SemiImplicitEuler {
+        template <bool ZeroGravity, typename V>
+        static void step(V& x, V& y, V vx, V& vy, V g, V h) {
+            if constexpr (!ZeroGravity) {
+                vy = vy + g * h;
+            }
+            x = x + vx * h;
+            y = y + vy * h;
+        }
+    };
+
+    struct VelocityVerlet {
+        template <bool ZeroGravity, typename V>
+        static void step(V& x, V& y, V vx, V& vy, V g, V h) {
+            if constexpr (ZeroGravity) {
+                SemiImplicitEuler::step<true>(x, y, vx, vy, g, h);
+            } else {
+                V halfKick = V(0.5f) * g * h;
+                vy = vy + halfKick;
+                x = x + vx * h;
+                y = y + vy * h;
+                vy = vy + halfKick;
+            }
+        }
+    };
+
+    struct PositionVerlet {
+        template <bool ZeroGravity, typename V>
+        static void step(V& x, V& y, V vx, V& vy, V g, V h) {
+            if constexpr (ZeroGravity) {
+                SemiImplicitEuler::step<true>(x, y, vx, vy, g, h);
+            } else {
+                V halfStep = V(0.5f) * h;
+                y = y + vy * halfStep;
+                vy = vy + g * h;
+                y = y + vy * halfStep;
+                x = x + vx * h;
+            }
+        }
+    };
+}
@@ -0,0 +1,171 @@
+#include "MultiRateStepper.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+MultiRateStepper::MultiRateStepper(float worldWidth, float worldHeight)
+    : enabled(false)
+    , wasEnabled(false)
+    , worldWidth(worldWidth)
+    , worldHeight(worldHeight)
+    , phase(0)
+    , elapsed{}
+    , coarseCount(0)
+    , regionsX(1)
+    , regionsY(1)
+{
+}
+
+void MultiRateStepper::beginStep(BallStore& balls, float gravity, float deltaTime, JobSystem* jobs) {
+    if (!enabled) {
+        if (wasEnabled) {
+            reset(balls);
+        }
+        return;
+    }
+    wasEnabled = true;
+
+    if (phase == 0) {
+        assignLevels(balls, gravity, deltaTime, jobs);
+    }
+
+    // Scale per level for this step: the block's time on its last step, 0
+    // before. Summing the steps keeps blocks exact when deltaTime varies.
+    float scale[LEVEL_COUNT];
+    for (int k = 0; k < LEVEL_COUNT; ++k) {
+        elapsed[k] += deltaTime;
+        scale[k] = 0.0f;
+        if ((phase + 1) % (1 << k) == 0) {
+            scale[k] = elapsed[k] / deltaTime;
+            elapsed[k] = 0.0f;
+        }
+    }
+    phase = (phase + 1) % (1 << Config::MULTIRATE_MAX_LEVEL);
+
+    // Sleeping balls keep their zero scale and drop back to level 0, so
+    // they wake in step with everyone
+    auto apply = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (balls.island[i] != 0) {
+                balls.rateLevel[i] = 0;
+            } else {
+                balls.stepScale[i] = scale[balls.rateLevel[i]];
+            }
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(balls.size(), Config::PARALLEL_GRAIN_SIZE, apply);
+    } else {
+        apply(0, balls.size());
+    }
+}
+
+void MultiRateStepper::assignLevels(BallStore& balls, float gravity, float deltaTime, JobSystem* jobs) {
+    coarseCount = 0;
+    const size_t count = balls.size();
+    if (count == 0) {
+        return;
+    }
+
+    float maxRadius = 0.0f;
+    float maxSpeedSquared = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        maxRadius = std::max(maxRadius, balls.radius[i]);
+        maxSpeedSquared = std::max(maxSpeedSquared, balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i]);
+    }
+
+    // Regions of whole grid cells (same cell size rule as the uniform grid)
+    const float cellSize = 2.0f * maxRadius * (1.0f + Config::GRID_CELL_MARGIN);
+    const float regionSize = Config::MULTIRATE_REGION_CELLS * cellSize;
+    const float invRegionSize = 1.0f / regionSize;
+    regionsX = std::max(1, static_cast<int>(std::ceil(worldWidth * invRegionSize)));
+    regionsY = std::max(1, static_cast<int>(std::ceil(worldHeight * invRegionSize)));
+    regionCount.assign(static_cast<size_t>(regionsX) * regionsY, 0);
+    ballRegion.resize(count);
+
+    // Balls outside the world clamp into the border regions, which only
+    // ever makes a region look more crowded
+    for (size_t i = 0; i < count; ++i) {
+        float rx = std::floor(balls.x[i] * invRegionSize);
+        float ry = std::floor(balls.y[i] * invRegionSize);
+        int cx = static_cast<int>(std::min(std::max(rx, 0.0f), static_cast<float>(regionsX - 1)));
+        int cy = static_cast<int>(std::min(std::max(ry, 0.0f), static_cast<float>(regionsY - 1)));
+        ballRegion[i] = static_cast<uint32_t>(cy * regionsX + cx);
+        ++regionCount[ballRegion[i]];
+    }
+
+    const float maxSpeed = std::sqrt(maxSpeedSquared);
+    const float acceleration = std::fabs(gravity);
+    std::atomic<size_t> coarse(0);
+
+    auto assign = [&](size_t begin, size_t end) {
+        size_t localCoarse = 0;
+        for (size_t i = begin; i < end; ++i) {
+            uint8_t level = 0;
+            if (balls.island[i] == 0 && regionCount[ballRegion[i]] == 1) {
+                // First ring of regions around the ball's own that holds
+                // another ball; every ball inside it is at least
+                // (ring - 1) regions away
+                const int cx = static_cast<int>(ballRegion[i] % regionsX);
+                const int cy = static_cast<int>(ballRegion[i] / regionsX);
+                int ring = 1;
+                while (ring <= Config::MULTIRATE_SEARCH_RINGS && !isRingEmpty(cx, cy, ring)) {
+                    ++ring;
+                }
+                float clearance = static_cast<float>(ring - 1) * regionSize - 2.0f * maxRadius;
+
+                // Both balls may gain |g| T of speed during a block of length T
+                float closingSpeed = std::sqrt(balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i]) + maxSpeed;
+                while (level < Config::MULTIRATE_MAX_LEVEL) {
+                    float block = deltaTime * static_cast<float>(2 << level);
+                    if ((closingSpeed + acceleration * block) * block > clearance) {
+                        break;
+                    }
+                    ++level;
+                }
+            }
+            balls.rateLevel[i] = level;
+            localCoarse += level > 0 ? 1 : 0;
+        }
+        coarse.fetch_add(localCoarse, std::memory_order_relaxed);
+    };
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, assign);
+    } else {
+        assign(0, count);
+    }
+    coarseCount = coarse.load(std::memory_order_relaxed);
+}
+
+bool MultiRateStepper::isRingEmpty(int cx, int cy, int ring) const {
+    // Regions at Chebyshev distance `ring`; the ones past the grid edge are
+    // empty (outside balls are clamped into the border regions)
+    for (int y = cy - ring; y <= cy + ring; ++y) {
+        if (y < 0 || y >= regionsY) {
+            continue;
+        }
+        const bool edgeRow = y == cy - ring || y == cy + ring;
+        const int step = edgeRow ? 1 : 2 * ring;
+        for (int x = cx - ring; x <= cx + ring; x += step) {
+            if (x >= 0 && x < regionsX && regionCount[y * regionsX + x] != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void MultiRateStepper::reset(BallStore& balls) {
+    // Turned off mid-block: waiting balls lose the rest of their block,
+    // which is at most 2^MULTIRATE_MAX_LEVEL - 1 steps
+    for (size_t i = 0; i < balls.size(); ++i) {
+        balls.rateLevel[i] = 0;
+        if (balls.island[i] == 0) {
+            balls.stepScale[i] = 1.0f;
+        }
+    }
+    wasEnabled = false;
+    phase = 0;
+    std::fill(elapsed, elapsed + LEVEL_COUNT, 0.0f);
+    coarseCount = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include "../core/Config.h"
+#include <cstdint>
+#include <vector>
+
+// Multi-rate time stepping by region.
+// Every 2^MULTIRATE_MAX_LEVEL steps all balls are at the same time (a
+// synchronization point) and each awake ball gets a level k: it is then
+// integrated once every 2^k steps, on the last step of each block, by the
+// time that passed during the block. In between its step scale is 0, so it
+// waits at the start-of-block state like a sleeping ball, and every level's
+// block ends on a synchronization point.
+//
+// Levels come from square regions of MULTIRATE_REGION_CELLS broadphase
+// grid cells. A ball alone in its region looks for the nearest ring of
+// regions around it (up to MULTIRATE_SEARCH_RINGS) that holds another ball;
+// every other ball is then at least that many regions minus one away. The
+// ball gets the largest level for which it and the fastest ball in the
+// scene together cannot close that clearance within one block, even if
+// gravity speeds both up for the whole block (each moves at most
+// v T + |g| T² / 2 in a block of length T). Balls
+// sharing a region (piles, clusters) keep level 0 and pay for every step.
+// Wall contacts of coarse balls are caught by the discrete wall test and
+// the continuous sweep.
+//
+// The level lives in the BallStore rateLevel column, so it follows culling
+// and permutes. Spawned and woken balls start at level 0.
+class MultiRateStepper {
+public:
+    MultiRateStepper(float worldWidth, float worldHeight);
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    // Before integration: assign levels at a synchronization point, then set
+    // the step scale of every awake ball for this step
+    void beginStep(BallStore& balls, float gravity, float deltaTime, JobSystem* jobs);
+
+    size_t getCoarseCount() const { return coarseCount; }  // Balls above level 0 at the last assignment
+
+    // No ball is waiting inside a block (always true while disabled)
+    bool isSynchronized() const { return phase == 0; }
+
+private:
+    static constexpr int LEVEL_COUNT = Config::MULTIRATE_MAX_LEVEL + 1;
+
+    bool enabled;
+    bool wasEnabled;
+    float worldWidth, worldHeight;
+    int phase;                    // Steps since the last synchronization point
+    float elapsed[LEVEL_COUNT];   // Time since each level's block started
+    size_t coarseCount;
+
+    // Region occupancy scratch
+    int regionsX, regionsY;
+    std::vector<uint32_t> regionCount;
+    std::vector<uint32_t> ballRegion;
+
+    void assignLevels(BallStore& balls, float gravity, float deltaTime, JobSystem* jobs);
+    bool isRingEmpty(int cx, int cy, int ring) const;
+    void reset(BallStore& balls);
+};
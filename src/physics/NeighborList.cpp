@@ -0,0 +1,180 @@
+#include "NeighborList.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <atomic>
+
+NeighborList::NeighborList()
+    : grid(2.0f * Config::BALL_RADIUS, 1.0f, 1.0f)
+    , originX(0.0f)
+    , originY(0.0f)
+    , worldWidth(1.0f)
+    , worldHeight(1.0f)
+    , maxRadius(Config::BALL_RADIUS)
+    , valid(false)
+    , skin(0.0f)
+    , builtMaxRadius(0.0f)
+    , layoutVersion(0)
+    , rebuildCount(0)
+{
+}
+
+void NeighborList::configure(float newOriginX, float newOriginY, float newWorldWidth, float newWorldHeight,
+                             float newMaxRadius) {
+    originX = newOriginX;
+    originY = newOriginY;
+    worldWidth = newWorldWidth;
+    worldHeight = newWorldHeight;
+    maxRadius = newMaxRadius;
+}
+
+void NeighborList::build(const BallStore& balls, JobSystem* jobs) {
+    // A larger ball than any at the gather invalidates the skin bound
+    bool stale = !followLayout(balls) || maxRadius > builtMaxRadius;
+    if (stale || hasMovedTooFar(balls, jobs)) {
+        gather(balls, jobs);
+    }
+}
+
+bool NeighborList::followLayout(const BallStore& balls) {
+    if (!valid) {
+        return false;
+    }
+
+    const uint64_t version = balls.getLayoutVersion();
+    if (version == layoutVersion) {
+        return balls.size() == refX.size();  // Spawns need a new gather
+    }
+    if (version != layoutVersion + 1) {
+        return false;
+    }
+
+    // Drop removed balls from the lists and renumber the rest. Only an
+    // order-preserving removal keeps every list ahead of its owner; a
+    // permute, or rows appended around the removal, needs a new gather.
+    const std::vector<uint32_t>& remap = balls.getLastRemap();
+    const size_t oldCount = refX.size();
+    if (remap.size() != oldCount) {
+        return false;
+    }
+
+    remappedStart.assign(1, 0);
+    remappedNeighbors.clear();
+    size_t survivors = 0;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < oldCount; ++i) {
+        const uint32_t mapped = remap[i];
+        if (mapped == BallStore::REMOVED) {
+            continue;
+        }
+        if (survivors > 0 && mapped <= previous) {
+            return false;
+        }
+        previous = mapped;
+
+        for (uint32_t k = neighborStart[i]; k < neighborStart[i + 1]; ++k) {
+            const uint32_t neighbor = remap[neighbors[k]];
+            if (neighbor != BallStore::REMOVED) {
+                remappedNeighbors.push_back(neighbor);
+            }
+        }
+        remappedStart.push_back(static_cast<uint32_t>(remappedNeighbors.size()));
+        refX[survivors] = refX[i];
+        refY[survivors] = refY[i];
+        ++survivors;
+    }
+    if (survivors != balls.size()) {
+        return false;
+    }
+
+    refX.resize(survivors);
+    refY.resize(survivors);
+    neighborStart.swap(remappedStart);
+    neighbors.swap(remappedNeighbors);
+    layoutVersion = version;
+    return true;
+}
+
+bool NeighborList::hasMovedTooFar(const BallStore& balls, JobSystem* jobs) const {
+    const float limit = 0.25f * skin * skin;  // (skin / 2)²
+    std::atomic<bool> tooFar(false);
+
+    auto check = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float dx = balls.x[i] - refX[i];
+            float dy = balls.y[i] - refY[i];
+            if (dx * dx + dy * dy > limit) {
+                tooFar.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    };
+
+    if (jobs) {
+        jobs->parallelFor(balls.size(), Config::PARALLEL_GRAIN_SIZE, check);
+    } else {
+        check(0, balls.size());
+    }
+    return tooFar.load(std::memory_order_relaxed);
+}
+
+void NeighborList::gather(const BallStore& balls, JobSystem* jobs) {
+    const size_t count = balls.size();
+    skin = Config::NEIGHBOR_SKIN_RATIO * maxRadius;
+    builtMaxRadius = maxRadius;
+
+    // Cells cover the furthest listed pair: two of the largest balls plus the skin
+    grid.configure(originX, originY, worldWidth, worldHeight, 2.0f * maxRadius + skin);
+    grid.build(balls, jobs);
+
+    auto forEachNeighbor = [&](size_t i, auto&& fn) {
+        const float xi = balls.x[i];
+        const float yi = balls.y[i];
+        const float reachBase = balls.radius[i] + skin;
+        grid.forEachNearby(xi, yi, [&](uint32_t j) {
+            if (j <= i) {
+                return;
+            }
+            float dx = balls.x[j] - xi;
+            float dy = balls.y[j] - yi;
+            float reach = reachBase + balls.radius[j];
+            if (dx * dx + dy * dy < reach * reach) {
+                fn(j);
+            }
+        });
+    };
+
+    auto runParallel = [&](auto&& fn) {
+        if (jobs) {
+            jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, fn);
+        } else {
+            fn(static_cast<size_t>(0), count);
+        }
+    };
+
+    // Count, prefix sum, then fill: each ball writes only its own range
+    neighborStart.assign(count + 1, 0);
+    runParallel([&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t found = 0;
+            forEachNeighbor(i, [&](uint32_t) { ++found; });
+            neighborStart[i + 1] = found;
+        }
+    });
+    for (size_t i = 0; i < count; ++i) {
+        neighborStart[i + 1] += neighborStart[i];
+    }
+
+    neighbors.resize(neighborStart[count]);
+    runParallel([&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t write = neighborStart[i];
+            forEachNeighbor(i, [&](uint32_t j) { neighbors[write++] = j; });
+        }
+    });
+
+    refX.assign(balls.x.begin(), balls.x.end());
+    refY.assign(balls.y.begin(), balls.y.end());
+    layoutVersion = balls.getLayoutVersion();
+    valid = true;
+    ++rebuildCount;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include "SpatialGrid.h"
+#include <cstdint>
+#include <vector>
+
+// Verlet neighbor lists: candidate pairs are gathered with a skin margin
+// and reused until some ball has moved more than half the skin since the
+// gather. Two balls that were further apart than their radii plus the skin
+// then cannot have closed the gap, so the lists stay complete while the
+// grid is only rebuilt every few steps. Displacement is checked per ball
+// against its position at the last gather.
+//
+// Lists are stored per ball (CSR layout, only neighbours with a higher
+// index). Culling is folded in through the BallStore layout remap; spawns
+// force a fresh gather since a new ball has no list.
+class NeighborList {
+public:
+    NeighborList();
+
+    // Extents for the gather grid and the largest live ball radius
+    void configure(float originX, float originY, float worldWidth, float worldHeight, float maxRadius);
+
+    // Re-gather the lists if they may be stale; otherwise only check displacement
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every listed pair
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+    size_t getRebuildCount() const { return rebuildCount; }
+
+private:
+    SpatialGrid grid;
+    float originX, originY;
+    float worldWidth, worldHeight;
+    float maxRadius;
+
+    // State of the last gather
+    bool valid;
+    float skin;
+    float builtMaxRadius;
+    uint64_t layoutVersion;
+    size_t rebuildCount;
+    std::vector<float> refX, refY;  // Ball positions at the gather
+
+    std::vector<uint32_t> neighborStart;  // balls + 1 offsets into neighbors
+    std::vector<uint32_t> neighbors;      // Neighbours of each ball (higher indices only)
+
+    // Scratch for following a removal
+    std::vector<uint32_t> remappedStart;
+    std::vector<uint32_t> remappedNeighbors;
+
+    bool followLayout(const BallStore& balls);
+    bool hasMovedTooFar(const BallStore& balls, JobSystem* jobs) const;
+    void gather(const BallStore& balls, JobSystem* jobs);
+};
+
+template <typename Visitor>
+void NeighborList::forEachPotentialCollision(Visitor&& visit) const {
+    const uint32_t count = static_cast<uint32_t>(refX.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t k = neighborStart[i]; k < neighborStart[i + 1]; ++k) {
+            visit(i, neighbors[k]);
+        }
+    }
+}
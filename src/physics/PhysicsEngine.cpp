@@ -1,66 +1,558 @@
 #include "PhysicsEngine.h"
+#include "IntegrationKernel.h"
+#include "ContainerKernel.h"
+#include "ContinuousCollision.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
-PhysicsEngine::PhysicsEngine(float gravity)
+PhysicsEngine::PhysicsEngine(float gravity, float worldWidth, float worldHeight)
     : gravity(gravity)
-    , spatialGrid(50.0f, 1024.0f, 768.0f)  // Cell size = 2 × ball diameter
+    , worldWidth(worldWidth)
+    , worldHeight(worldHeight)
+    , jobs(nullptr)
+    , broadphaseType(BroadphaseType::UniformGrid)
+    , reorderInterval(0)
+    , stepsSinceReorder(0)
+    , spatialGrid(2.0f * Config::BALL_RADIUS * (1.0f + Config::GRID_CELL_MARGIN), worldWidth, worldHeight)
+    , hierarchicalGrid(2.0f * Config::BALL_RADIUS * (1.0f + Config::GRID_CELL_MARGIN), worldWidth, worldHeight)
+    , spatialHash(2.0f * Config::BALL_RADIUS)
+    , incrementalGrid(2.0f * Config::BALL_RADIUS * (1.0f + Config::GRID_CELL_MARGIN), worldWidth, worldHeight)
+    , multiRate(worldWidth, worldHeight)
+    , solverType(SolverType::Pairwise)
+    , solverIterations(Config::SOLVER_ITERATIONS)
+    , continuousCollision(true)
+    , sweptCount(0)
+    , integratorType(IntegratorType::SemiImplicitEuler)
+    , eventDriven(false)
+    , eventDrivenActive(false)
+    , deterministic(false)
+    , uniformMass(false)
+    , massLayoutVersion(0)
+    , massCheckedCount(0)
 {
 }
 
-void PhysicsEngine::update(std::vector<Ball>& balls, const Container& container, float deltaTime, float restitution) {
-    // Apply gravity to all balls
+void PhysicsEngine::update(BallStore& balls, const Container& container, float deltaTime, float restitution) {
+    sleep.beginStep(balls, container, gravity);
+
+    // Straight-line motion between exact contacts. It only takes over at a
+    // multi-rate synchronization point, so no ball loses the rest of its
+    // block (multi-rate stays at that point while events run).
+    eventDrivenActive = eventDriven && gravity == 0.0f && restitution <= 1.0f && multiRate.isSynchronized()
+                        && isSparse(balls, container);
+    if (eventDrivenActive) {
+        sweptCount = 0;
+        eventSimulator.advance(balls, container, deltaTime, restitution);
+        return;
+    }
+
+    multiRate.beginStep(balls, gravity, deltaTime, jobs);
+
+    if (solverType == SolverType::SequentialImpulse) {
+        stepSequentialImpulse(balls, container, deltaTime, restitution);
+    } else if (solverType == SolverType::PositionBased) {
+        stepPositionBased(balls, container, deltaTime, restitution);
+    } else {
+        // Apply gravity and update positions in one pass
+        integrate(balls, gravity, deltaTime);
+        // The Verlet integrators drift half a kick behind the end velocity
+        const float driftLag = integratorType == IntegratorType::SemiImplicitEuler ? 0.0f : 0.5f * gravity;
+        sweepFastBalls(balls, container, deltaTime, restitution, driftLag);
+
+        // Fit the grid to the container and the live ball sizes
+        if (broadphaseType != BroadphaseType::SweepAndPrune && broadphaseType != BroadphaseType::AabbTree) {
+            updateGridLayout(balls, container);
+        }
+
+        // Handle all collisions
+        handleCollisions(balls, container, restitution);
+    }
+
+    updateSleep(balls, container, deltaTime);
+}
+
+bool PhysicsEngine::isSparse(const BallStore& balls, const Container& container) const {
+    float area = 0.0f;
+    for (float r : balls.radius) {
+        area += r * r;
+    }
+    float radius = container.getRadius();
+    return area <= Config::EVENT_MAX_PACKING * radius * radius;
+}
+
+template <typename Fn>
+void PhysicsEngine::parallelFor(size_t count, Fn&& fn) {
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, fn);
+    } else {
+        fn(static_cast<size_t>(0), count);
+    }
+}
+
+template <typename Fn>
+void PhysicsEngine::withBroadphase(Fn&& fn) {
+    switch (broadphaseType) {
+        case BroadphaseType::SweepAndPrune: fn(sweepAndPrune); break;
+        case BroadphaseType::AabbTree: fn(aabbTree); break;
+        case BroadphaseType::HierarchicalGrid: fn(hierarchicalGrid); break;
+        case BroadphaseType::SpatialHash: fn(spatialHash); break;
+        case BroadphaseType::NeighborList: fn(neighborList); break;
+        case BroadphaseType::IncrementalGrid: fn(incrementalGrid); break;
+        case BroadphaseType::UniformGrid:
+        default: fn(spatialGrid); break;
+    }
+}
+
+template <typename Fn>
+void PhysicsEngine::withContactPolicy(float restitution, Fn&& fn) {
+    if (restitution == 1.0f) {
+        if (uniformMass) {
+            fn(ContactPolicy<true, true>{});
+        } else {
+            fn(ContactPolicy<true, false>{});
+        }
+    } else if (uniformMass) {
+        fn(ContactPolicy<false, true>{});
+    } else {
+        fn(GeneralContacts{});
+    }
+}
+
+void PhysicsEngine::integrate(BallStore& balls, float acceleration, float deltaTime) {
+    // Sleeping balls (and multi-rate balls inside their block) have a zero
+    // step scale and stay where they are
+    const bool scaled = usesStepScale();
+    const IntegrationKernel::Function kernel = IntegrationKernel::select(integratorType, acceleration == 0.0f, scaled);
+    parallelFor(balls.size(), [&](size_t begin, size_t end) {
+        kernel(
+            balls.x.data() + begin, balls.y.data() + begin,
+            balls.vx.data() + begin, balls.vy.data() + begin,
+            scaled ? balls.stepScale.data() + begin : nullptr,
+            end - begin, acceleration, deltaTime
+        );
+    });
+}
+
+void PhysicsEngine::updateMassUniformity(const BallStore& balls) {
+    // A re-layout may have removed the odd ball out, so rescan everything;
+    // otherwise only rows appended since the last check are new
+    if (balls.getLayoutVersion() != massLayoutVersion || massCheckedCount > balls.size()) {
+        massLayoutVersion = balls.getLayoutVersion();
+        massCheckedCount = 0;
+        uniformMass = true;
+    }
+    if (balls.empty()) {
+        return;
+    }
+
+    const float reference = balls.invMass[0];
+    for (size_t i = massCheckedCount; i < balls.size() && uniformMass; ++i) {
+        uniformMass = balls.invMass[i] == reference;
+    }
+    uniformMass = uniformMass && reference > 0.0f;
+    massCheckedCount = balls.size();
+}
+
+void PhysicsEngine::updateGridLayout(const BallStore& balls, const Container& container) {
+    if (balls.empty()) {
+        return;
+    }
+
+    float minRadius = balls.radius[0];
+    float maxRadius = balls.radius[0];
+    for (float r : balls.radius) {
+        minRadius = std::min(minRadius, r);
+        maxRadius = std::max(maxRadius, r);
+    }
+
+    // The hash has no extents; its power-of-two cells only have to cover
+    // two of the largest balls
+    if (broadphaseType == BroadphaseType::SpatialHash) {
+        spatialHash.setMinCellSize(2.0f * maxRadius);
+        return;
+    }
+
+    // Extents: the container (plus one ball) unioned with the world area.
+    // Anything beyond is clamped into the border cells by the grid.
+    Vector2D center = container.getCenter();
+    float reach = container.getRadius() + 2.0f * maxRadius;
+    float minX = std::min(0.0f, center.x - reach);
+    float minY = std::min(0.0f, center.y - reach);
+    float maxX = std::max(worldWidth, center.x + reach);
+    float maxY = std::max(worldHeight, center.y + reach);
+
+    if (broadphaseType == BroadphaseType::HierarchicalGrid) {
+        configureHierarchicalGrid(minX, minY, maxX, maxY, minRadius, maxRadius);
+    } else if (broadphaseType == BroadphaseType::NeighborList) {
+        neighborList.configure(minX, minY, maxX - minX, maxY - minY, maxRadius);
+    } else {
+        configureGrid(minX, minY, maxX, maxY, maxRadius);
+    }
+}
+
+void PhysicsEngine::configureGrid(float minX, float minY, float maxX, float maxY, float maxRadius) {
+    // Cell size must cover the largest possible contact distance (two of the
+    // largest balls). Only grow immediately; shrink once the current cells
+    // are clearly too coarse so slider drags do not re-tune every step.
+    const bool incremental = broadphaseType == BroadphaseType::IncrementalGrid;
+    float cellSize = incremental ? incrementalGrid.getCellSize() : spatialGrid.getCellSize();
+    float requiredCellSize = 2.0f * maxRadius * (1.0f + Config::GRID_CELL_MARGIN);
+    if (requiredCellSize > cellSize || requiredCellSize < cellSize * Config::GRID_CELL_SHRINK_RATIO) {
+        cellSize = requiredCellSize;
+    }
+
+    if (incremental) {
+        incrementalGrid.configure(minX, minY, maxX - minX, maxY - minY, cellSize);
+    } else {
+        spatialGrid.configure(minX, minY, maxX - minX, maxY - minY, cellSize);
+    }
+}
+
+void PhysicsEngine::configureHierarchicalGrid(float minX, float minY, float maxX, float maxY,
+                                              float minRadius, float maxRadius) {
+    // The finest level fits the smallest ball (same hysteresis as the
+    // uniform grid); coarser levels double until the largest ball fits
+    float baseCellSize = hierarchicalGrid.getBaseCellSize();
+    float requiredCellSize = 2.0f * minRadius * (1.0f + Config::GRID_CELL_MARGIN);
+    if (requiredCellSize > baseCellSize || requiredCellSize < baseCellSize * Config::GRID_CELL_SHRINK_RATIO) {
+        baseCellSize = requiredCellSize;
+    }
+
+    // With the level count capped, coarsen the base instead of leaving the
+    // largest balls without a level
+    const float topScale = static_cast<float>(1 << (Config::HGRID_MAX_LEVELS - 1));
+    baseCellSize = std::max(baseCellSize, 2.0f * maxRadius / topScale);
+
+    int levelCount = 1;
+    for (float size = baseCellSize; size < 2.0f * maxRadius; size *= 2.0f) {
+        ++levelCount;
+    }
+
+    hierarchicalGrid.configure(minX, minY, maxX - minX, maxY - minY, baseCellSize, levelCount);
+}
+
+void PhysicsEngine::applyGravity(BallStore& balls, float deltaTime) {
+    const float dv = gravity * deltaTime;
+    const bool scaled = usesStepScale();
+    parallelFor(balls.size(), [&](size_t begin, size_t end) {
+        float* vy = balls.vy.data();
+        const float* scale = balls.stepScale.data();
+        for (size_t i = begin; i < end; ++i) {
+            vy[i] += scaled ? gravity * (deltaTime * scale[i]) : dv;
+        }
+    });
+}
+
+void PhysicsEngine::stepSequentialImpulse(BallStore& balls, const Container& container, float deltaTime,
+                                          float restitution) {
+    // Velocity first, so resting contacts see (and cancel) this step's gravity
     applyGravity(balls, deltaTime);
 
-    // Update ball positions based on velocity
-    updatePositions(balls, deltaTime);
+    // Contacts from the start-of-step positions
+    if (broadphaseType != BroadphaseType::SweepAndPrune && broadphaseType != BroadphaseType::AabbTree) {
+        updateGridLayout(balls, container);
+    }
+    withBroadphase([&](auto& broadphase) {
+        broadphase.build(balls, jobs);
+    });
+    if (broadphaseType == BroadphaseType::UniformGrid) {
+        reorderByCell(balls);
+    }
+
+    contactSolver.begin(balls);
+    withBroadphase([&](auto& broadphase) {
+        broadphase.forEachPotentialCollision([&](uint32_t a, uint32_t b) {
+            const bool sleepingA = balls.island[a] != 0;
+            const bool sleepingB = balls.island[b] != 0;
+            if (sleepingA && sleepingB) {
+                return;
+            }
+
+            float dx = balls.x[b] - balls.x[a];
+            float dy = balls.y[b] - balls.y[a];
+            float reach = balls.radius[a] + balls.radius[b];
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared >= reach * reach) {
+                return;
+            }
+            if ((sleepingA || sleepingB) && distanceSquared > 0.0f) {
+                float inverseDistance = 1.0f / std::sqrt(distanceSquared);
+                wakeOnImpact(balls, a, b, dx * inverseDistance, dy * inverseDistance);
+            }
+            contactSolver.addBallContact(balls, a, b);
+        });
+    });
+    contactSolver.addWallContacts(balls, ContainerKernel::makeParams(container, restitution));
 
-    // Handle all collisions
-    handleCollisions(balls, container, restitution);
+    contactSolver.solve(balls, deltaTime, restitution, solverIterations);
+
+    // Move with the solved velocities
+    integrate(balls, 0.0f, deltaTime);
+    sweepFastBalls(balls, container, deltaTime, restitution);
 }
 
-void PhysicsEngine::applyGravity(std::vector<Ball>& balls, float deltaTime) {
-    for (Ball& ball : balls) {
-        ball.applyGravity(gravity, deltaTime);
+void PhysicsEngine::stepPositionBased(BallStore& balls, const Container& container, float deltaTime,
+                                      float restitution) {
+    positionSolver.predict(balls, usesStepScale() ? balls.stepScale.data() : nullptr, gravity, deltaTime, jobs);
+
+    // Contacts near the predicted positions
+    if (broadphaseType != BroadphaseType::SweepAndPrune && broadphaseType != BroadphaseType::AabbTree) {
+        updateGridLayout(balls, container);
+    }
+    withBroadphase([&](auto& broadphase) {
+        broadphase.build(balls, jobs);
+        broadphase.forEachPotentialCollision([&](uint32_t a, uint32_t b) {
+            const bool sleepingA = balls.island[a] != 0;
+            const bool sleepingB = balls.island[b] != 0;
+            if (sleepingA && sleepingB) {
+                return;
+            }
+            if (sleepingA || sleepingB) {
+                float dx = balls.x[b] - balls.x[a];
+                float dy = balls.y[b] - balls.y[a];
+                float reach = balls.radius[a] + balls.radius[b];
+                float distanceSquared = dx * dx + dy * dy;
+                if (distanceSquared < reach * reach && distanceSquared > 0.0f) {
+                    float inverseDistance = 1.0f / std::sqrt(distanceSquared);
+                    wakeOnImpact(balls, a, b, dx * inverseDistance, dy * inverseDistance);
+                }
+            }
+            positionSolver.addBallPair(balls, a, b);
+        });
+    });
+    positionSolver.addWallContacts(balls, ContainerKernel::makeParams(container, restitution));
+
+    positionSolver.solve(balls, deltaTime, restitution, solverIterations);
+    sweepFastBalls(balls, container, deltaTime, restitution);
+
+    // The solver indexes balls by slot, so sort only once it is done
+    if (broadphaseType == BroadphaseType::UniformGrid) {
+        reorderByCell(balls);
     }
 }
 
-void PhysicsEngine::updatePositions(std::vector<Ball>& balls, float deltaTime) {
-    for (Ball& ball : balls) {
-        ball.update(deltaTime);
+void PhysicsEngine::sweepFastBalls(BallStore& balls, const Container& container, float deltaTime,
+                                   float restitution, float driftLag) {
+    sweptCount = 0;
+    if (!continuousCollision) {
+        return;
     }
+
+    // Independent per ball; the container has already rotated to the end
+    // of the step
+    const ContinuousCollision::Params params = ContinuousCollision::makeParams(container, restitution, deltaTime, driftLag);
+    std::atomic<size_t> swept(0);
+    parallelFor(balls.size(), [&](size_t begin, size_t end) {
+        size_t count = ContinuousCollision::sweepFast(
+            balls.x.data() + begin, balls.y.data() + begin,
+            balls.vx.data() + begin, balls.vy.data() + begin,
+            balls.radius.data() + begin, usesStepScale() ? balls.stepScale.data() + begin : nullptr,
+            end - begin, params
+        );
+        swept.fetch_add(count, std::memory_order_relaxed);
+    });
+    sweptCount = swept.load(std::memory_order_relaxed);
 }
 
-void PhysicsEngine::handleCollisions(std::vector<Ball>& balls, const Container& container, float restitution) {
-    // Handle ball-ball collisions
-    handleBallBallCollisions(balls, restitution);
+void PhysicsEngine::handleCollisions(BallStore& balls, const Container& container, float restitution) {
+    // Handle ball-ball collisions, specialized for this step's restitution
+    // and ball masses
+    updateMassUniformity(balls);
+    withContactPolicy(restitution, [&](auto policy) {
+        handleBallBallCollisions<decltype(policy)>(balls, restitution);
+    });
 
     // Handle ball-container collisions
     handleBallContainerCollisions(balls, container, restitution);
 }
 
-void PhysicsEngine::handleBallBallCollisions(std::vector<Ball>& balls, float restitution) {
-    // Rebuild spatial grid
-    spatialGrid.clear();
-    for (size_t i = 0; i < balls.size(); ++i) {
-        spatialGrid.insertBall(i, balls[i].position);
+template <typename Policy>
+inline void PhysicsEngine::resolveBallPair(BallStore& balls, uint32_t a, uint32_t b, float restitution) {
+    // Two sleeping balls are at rest against each other
+    const bool sleepingA = balls.island[a] != 0;
+    const bool sleepingB = balls.island[b] != 0;
+    if (sleepingA && sleepingB) {
+        return;
     }
 
-    // Get potential collision pairs
-    spatialGrid.getPotentialCollisions(balls, potentialCollisions);
+    // Cheap reject before the full check: most candidates do not touch
+    float dx = balls.x[b] - balls.x[a];
+    float dy = balls.y[b] - balls.y[a];
+    float reach = balls.radius[a] + balls.radius[b];
+    if (dx * dx + dy * dy >= reach * reach) {
+        return;
+    }
 
-    // Check only potential collisions
-    for (const auto& pair : potentialCollisions) {
-        CollisionInfo info = detector.checkBallCollision(balls[pair.first], balls[pair.second]);
-        if (info.hasCollision) {
-            resolver.resolveElasticCollision(balls[pair.first], balls[pair.second], info, restitution);
-        }
+    CollisionInfo info = detector.checkBallCollision(balls, a, b);
+    if (!info.hasCollision) {
+        return;
+    }
+    if (sleepingA || sleepingB) {
+        resolveSleepingPair<Policy>(balls, a, b, info, restitution);
+    } else {
+        resolver.resolveContact<Policy>(balls, a, b, info, restitution, balls.invMass[a], balls.invMass[b]);
     }
 }
 
-void PhysicsEngine::handleBallContainerCollisions(std::vector<Ball>& balls, const Container& container, float restitution) {
-    for (Ball& ball : balls) {
-        CollisionInfo info = detector.checkContainerCollision(ball, container);
-        if (info.hasCollision) {
-            resolver.resolveWallCollision(ball, info, restitution);
+template <typename Policy>
+void PhysicsEngine::resolveSleepingPair(BallStore& balls, uint32_t a, uint32_t b, const CollisionInfo& info,
+                                        float restitution) {
+    // A hard hit wakes the island and is resolved as usual; a gentle touch
+    // bounces off the sleeper as if it were static (so masses differ)
+    using StaticPolicy = ContactPolicy<Policy::elastic, false>;
+    if (wakeOnImpact(balls, a, b, info.normal.x, info.normal.y)) {
+        resolver.resolveContact<Policy>(balls, a, b, info, restitution, balls.invMass[a], balls.invMass[b]);
+    } else if (balls.island[a] != 0) {
+        resolver.resolveContact<StaticPolicy>(balls, a, b, info, restitution, 0.0f, balls.invMass[b]);
+    } else {
+        resolver.resolveContact<StaticPolicy>(balls, a, b, info, restitution, balls.invMass[a], 0.0f);
+    }
+}
+
+bool PhysicsEngine::wakeOnImpact(const BallStore& balls, uint32_t a, uint32_t b, float normalX, float normalY) {
+    // Approach speed of the awake ball along the normal (the sleeper is still)
+    float relativeX = balls.vx[b] - balls.vx[a];
+    float relativeY = balls.vy[b] - balls.vy[a];
+    float approachSpeed = -(relativeX * normalX + relativeY * normalY);
+    if (approachSpeed <= Config::SLEEP_WAKE_SPEED) {
+        return false;
+    }
+    sleep.requestWake(balls.island[a] != 0 ? a : b);
+    return true;
+}
+
+template <typename Policy, typename Broadphase>
+void PhysicsEngine::resolveCandidates(Broadphase& broadphase, BallStore& balls, float restitution) {
+    broadphase.build(balls, jobs);
+
+    // Test and resolve candidates in place while walking the broadphase
+    broadphase.forEachPotentialCollision([&](uint32_t a, uint32_t b) {
+        resolveBallPair<Policy>(balls, a, b, restitution);
+    });
+}
+
+template <typename Policy>
+void PhysicsEngine::handleBallBallCollisions(BallStore& balls, float restitution) {
+    switch (broadphaseType) {
+        case BroadphaseType::SweepAndPrune:
+            resolveCandidates<Policy>(sweepAndPrune, balls, restitution);
+            break;
+
+        case BroadphaseType::AabbTree:
+            resolveCandidates<Policy>(aabbTree, balls, restitution);
+            break;
+
+        case BroadphaseType::HierarchicalGrid:
+            resolveCandidates<Policy>(hierarchicalGrid, balls, restitution);
+            break;
+
+        case BroadphaseType::SpatialHash:
+            resolveCandidates<Policy>(spatialHash, balls, restitution);
+            break;
+
+        case BroadphaseType::NeighborList:
+            resolveCandidates<Policy>(neighborList, balls, restitution);
+            break;
+
+        case BroadphaseType::IncrementalGrid:
+            resolveCandidates<Policy>(incrementalGrid, balls, restitution);
+            break;
+
+        case BroadphaseType::UniformGrid:
+        default:
+            spatialGrid.build(balls, jobs);
+            reorderByCell(balls);
+
+            // The grid's cell layout also allows a parallel narrowphase;
+            // its order is the canonical one in deterministic mode
+            if (deterministic || (jobs && jobs->getThreadCount() > 1)) {
+                handleBallBallCollisionsParallel<Policy>(balls, restitution);
+            } else {
+                spatialGrid.forEachPotentialCollision([&](uint32_t a, uint32_t b) {
+                    resolveBallPair<Policy>(balls, a, b, restitution);
+                });
+            }
+            break;
+    }
+}
+
+void PhysicsEngine::reorderByCell(BallStore& balls) {
+    if (reorderInterval <= 0 || ++stepsSinceReorder < reorderInterval) {
+        return;
+    }
+    stepsSinceReorder = 0;
+
+    // Spawns append at the end and removals compact in place, so over time
+    // storage order drifts away from spatial order. The freshly built grid
+    // already holds the balls sorted by cell; adopting that order is one
+    // O(n) permutation, paid once every reorderInterval steps. The grid is
+    // renumbered rather than rebuilt, so this step's narrowphase already
+    // benefits.
+    balls.permute(spatialGrid.getBallsByCell());
+    spatialGrid.markBallsSorted();
+}
+
+template <typename Policy>
+void PhysicsEngine::handleBallBallCollisionsParallel(BallStore& balls, float restitution) {
+    // Cells are processed in a checkerboard of 3 x 2 phases. A cell's pairs
+    // reach one column either side and one row down, so two cells of the same
+    // phase (3 columns or 2 rows apart) never share a ball and can run
+    // concurrently without locks, and the result does not depend on how
+    // many threads share a phase.
+    const int gridWidth = spatialGrid.getGridWidth();
+    const int gridHeight = spatialGrid.getGridHeight();
+
+    auto resolvePair = [&](uint32_t a, uint32_t b) {
+        resolveBallPair<Policy>(balls, a, b, restitution);
+    };
+
+    for (int phaseY = 0; phaseY < 2; ++phaseY) {
+        for (int phaseX = 0; phaseX < 3; ++phaseX) {
+            const int columns = (gridWidth - phaseX + 2) / 3;
+            const int rows = (gridHeight - phaseY + 1) / 2;
+            if (columns <= 0 || rows <= 0) {
+                continue;
+            }
+
+            auto resolveCells = [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) {
+                    int cx = phaseX + 3 * static_cast<int>(k % columns);
+                    int cy = phaseY + 2 * static_cast<int>(k / columns);
+                    spatialGrid.visitCellPairs(cx, cy, resolvePair);
+                }
+            };
+            const size_t cellCount = static_cast<size_t>(columns) * rows;
+            if (jobs) {
+                jobs->parallelFor(cellCount, Config::PARALLEL_CELL_GRAIN_SIZE, resolveCells);
+            } else {
+                resolveCells(0, cellCount);
+            }
         }
     }
 }
+
+void PhysicsEngine::updateSleep(BallStore& balls, const Container& container, float deltaTime) {
+    if (!sleep.isEnabled()) {
+        return;
+    }
+
+    // Islands are found through whichever broadphase ran this step
+    withBroadphase([&](auto& broadphase) {
+        sleep.endStep(balls, container, broadphase, deltaTime, jobs);
+    });
+}
+
+void PhysicsEngine::handleBallContainerCollisions(BallStore& balls, const Container& container, float restitution) {
+    // Each ball only touches its own row, so chunks run independently
+    ContainerKernel::Params params = ContainerKernel::makeParams(container, restitution);
+    parallelFor(balls.size(), [&](size_t begin, size_t end) {
+        ContainerKernel::resolve(
+            balls.x.data() + begin, balls.y.data() + begin,
+            balls.vx.data() + begin, balls.vy.data() + begin,
+            balls.radius.data() + begin,
+            end - begin, params
+        );
+    });
+}
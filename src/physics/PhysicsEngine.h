@@ -1,34 +1,187 @@
 #pragma once
 
-#include "../entities/Ball.h"
+#include "../entities/BallStore.h"
 #include "../entities/Container.h"
 #include "CollisionDetector.h"
 #include "CollisionResolver.h"
 #include "SpatialGrid.h"
+#include "SweepAndPrune.h"
+#include "AabbTree.h"
+#include "HierarchicalGrid.h"
+#include "SpatialHash.h"
+#include "NeighborList.h"
+#include "IncrementalGrid.h"
+#include "Broadphase.h"
+#include "SleepSystem.h"
+#include "MultiRateStepper.h"
+#include "ContactSolver.h"
+#include "PositionSolver.h"
+#include "EventSimulator.h"
+#include "Solver.h"
+#include "Integrator.h"
+#include "../core/JobSystem.h"
 #include <vector>
 
 class PhysicsEngine {
 public:
-    PhysicsEngine(float gravity);
+    PhysicsEngine(float gravity, float worldWidth, float worldHeight);
 
     // Main physics update
-    void update(std::vector<Ball>& balls, const Container& container, float deltaTime, float restitution);
+    void update(BallStore& balls, const Container& container, float deltaTime, float restitution);
 
     // Configuration
     void setGravity(float gravity) { this->gravity = gravity; }
     float getGravity() const { return gravity; }
 
+    // Integrator of the pairwise solver (see Integrator.h). The kernel is
+    // specialized for gravity == 0, and ball-ball resolution for
+    // restitution == 1 and uniform ball mass; each step picks the matching
+    // instantiation, so slider changes take effect on the next step.
+    void setIntegrator(IntegratorType type) { integratorType = type; }
+    IntegratorType getIntegrator() const { return integratorType; }
+
+    // Broadphase selection
+    void setBroadphase(BroadphaseType type) { broadphaseType = type; }
+    BroadphaseType getBroadphase() const { return broadphaseType; }
+
+    // Locality (uniform grid only): every `steps` steps re-sort the ball
+    // storage by grid cell (0 = never), and optionally lay out and walk the
+    // grid cells in Morton order so the sort follows a Z-order curve
+    void setReorderInterval(int steps) { reorderInterval = steps; }
+    int getReorderInterval() const { return reorderInterval; }
+    void setMortonCellOrder(bool enabled) { spatialGrid.setMortonOrder(enabled); }
+
+    // Contact resolution. The sequential-impulse solver runs `iterations`
+    // velocity iterations per step over all contacts (at least one); the
+    // position-based solver runs as many projection iterations.
+    void setSolver(SolverType type) { solverType = type; }
+    SolverType getSolver() const { return solverType; }
+    void setSolverIterations(int iterations) { solverIterations = iterations < 1 ? 1 : iterations; }
+    int getSolverIterations() const { return solverIterations; }
+    size_t getContactCount() const {  // Contacts of the last impulse or position-based step
+        return solverType == SolverType::PositionBased ? positionSolver.getContactCount()
+                                                        : contactSolver.getContactCount();
+    }
+
+    // Continuous collision: balls moving more than CCD_DISPLACEMENT_RATIO of
+    // their radius per step are swept against the container wall so they
+    // cannot pass through it (see ContinuousCollision)
+    void setContinuousCollision(bool enabled) { continuousCollision = enabled; }
+    bool isContinuousCollisionEnabled() const { return continuousCollision; }
+    size_t getSweptCount() const { return sweptCount; }  // Balls swept by the last step
+
+    // Multi-rate stepping: isolated balls step once every 2, 4 or 8 steps
+    // while crowded regions take every step (see MultiRateStepper)
+    void setMultiRateEnabled(bool enabled) { multiRate.setEnabled(enabled); }
+    bool isMultiRateEnabled() const { return multiRate.isEnabled(); }
+    size_t getCoarseStepCount() const { return multiRate.getCoarseCount(); }  // Balls on coarse steps
+
+    // Event-driven mode: with gravity at 0, restitution at most 1 and balls
+    // covering at most EVENT_MAX_PACKING of the container, steps advance
+    // from contact to contact instead of integrating (see EventSimulator).
+    // Above 1, balls trapped between a wall and a neighbour gain energy on
+    // every contact without time passing, so those scenes keep stepping.
+    // Sleeping, multi-rate and the solver choice do not apply while it runs;
+    // with multi-rate on it starts at the next synchronization point.
+    void setEventDriven(bool enabled) { eventDriven = enabled; }
+    bool isEventDriven() const { return eventDriven; }
+    bool isEventDrivenActive() const { return eventDrivenActive; }  // The last step was event-driven
+    size_t getEventCount() const { return eventSimulator.getEventCount(); }
+
+    // Sleeping: resting contact islands stop being integrated and tested
+    // until disturbed (see SleepSystem)
+    void setSleepEnabled(bool enabled) { sleep.setEnabled(enabled); }
+    bool isSleepEnabled() const { return sleep.isEnabled(); }
+    size_t getSleepingCount() const { return sleep.getSleepingCount(); }
+
+    // Optional thread pool for the per-ball loops (nullptr = serial)
+    void setJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+    // Deterministic mode: results must not depend on the thread count. The
+    // uniform grid then always resolves cells in its parallel checkerboard
+    // order (run serially without a pool); the serial pair walks of the
+    // other broadphases and every per-ball loop already are.
+    void setDeterministic(bool enabled) { deterministic = enabled; }
+    bool isDeterministic() const { return deterministic; }
+
 private:
     float gravity;  // Pixels per second²
+    float worldWidth;   // Area balls live in before being culled
+    float worldHeight;
+    JobSystem* jobs;
     CollisionDetector detector;
     CollisionResolver resolver;
+    BroadphaseType broadphaseType;
+    int reorderInterval;
+    int stepsSinceReorder;
     SpatialGrid spatialGrid;
-    std::vector<std::pair<size_t, size_t>> potentialCollisions;
+    SweepAndPrune sweepAndPrune;
+    AabbTree aabbTree;
+    HierarchicalGrid hierarchicalGrid;
+    SpatialHash spatialHash;
+    NeighborList neighborList;
+    IncrementalGrid incrementalGrid;
+    SleepSystem sleep;
+    MultiRateStepper multiRate;
+    SolverType solverType;
+    int solverIterations;
+    ContactSolver contactSolver;
+    PositionSolver positionSolver;
+    bool continuousCollision;
+    size_t sweptCount;
+    IntegratorType integratorType;
+    bool eventDriven;
+    bool eventDrivenActive;
+    EventSimulator eventSimulator;
+    bool deterministic;
+
+    // Whether every ball has the same inverse mass, kept up to date from
+    // the rows appended since the last re-layout
+    bool uniformMass;
+    uint64_t massLayoutVersion;
+    size_t massCheckedCount;
 
     // Update steps
-    void applyGravity(std::vector<Ball>& balls, float deltaTime);
-    void updatePositions(std::vector<Ball>& balls, float deltaTime);
-    void handleCollisions(std::vector<Ball>& balls, const Container& container, float restitution);
-    void handleBallBallCollisions(std::vector<Ball>& balls, float restitution);
-    void handleBallContainerCollisions(std::vector<Ball>& balls, const Container& container, float restitution);
+    void integrate(BallStore& balls, float acceleration, float deltaTime);
+    bool usesStepScale() const { return sleep.isEnabled() || multiRate.isEnabled(); }
+    void applyGravity(BallStore& balls, float deltaTime);
+    // driftLag: see ContinuousCollision::makeParams
+    void sweepFastBalls(BallStore& balls, const Container& container, float deltaTime, float restitution,
+                        float driftLag = 0.0f);
+    void stepSequentialImpulse(BallStore& balls, const Container& container, float deltaTime, float restitution);
+    void stepPositionBased(BallStore& balls, const Container& container, float deltaTime, float restitution);
+    void updateGridLayout(const BallStore& balls, const Container& container);
+    void configureGrid(float minX, float minY, float maxX, float maxY, float maxRadius);
+    void configureHierarchicalGrid(float minX, float minY, float maxX, float maxY, float minRadius, float maxRadius);
+    void handleCollisions(BallStore& balls, const Container& container, float restitution);
+    template <typename Policy>
+    void handleBallBallCollisions(BallStore& balls, float restitution);
+    template <typename Policy>
+    void handleBallBallCollisionsParallel(BallStore& balls, float restitution);
+    void reorderByCell(BallStore& balls);
+    template <typename Policy>
+    void resolveBallPair(BallStore& balls, uint32_t a, uint32_t b, float restitution);
+    template <typename Policy>
+    void resolveSleepingPair(BallStore& balls, uint32_t a, uint32_t b, const CollisionInfo& info, float restitution);
+    void updateMassUniformity(const BallStore& balls);
+    bool isSparse(const BallStore& balls, const Container& container) const;
+    bool wakeOnImpact(const BallStore& balls, uint32_t a, uint32_t b, float normalX, float normalY);
+    void updateSleep(BallStore& balls, const Container& container, float deltaTime);
+
+    // Build any broadphase and resolve its candidates serially in place
+    template <typename Policy, typename Broadphase>
+    void resolveCandidates(Broadphase& broadphase, BallStore& balls, float restitution);
+    void handleBallContainerCollisions(BallStore& balls, const Container& container, float restitution);
+
+    // Call fn(broadphase) with the active broadphase object
+    template <typename Fn>
+    void withBroadphase(Fn&& fn);
+
+    // Call fn(policy) with the ContactPolicy matching this step
+    template <typename Fn>
+    void withContactPolicy(float restitution, Fn&& fn);
+
+    // Run fn(begin, end) over [0, count), split across the job system if any
+    template <typename Fn>
+    void parallelFor(size_t count, Fn&& fn);
 };
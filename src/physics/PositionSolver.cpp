@@ -0,0 +1,203 @@
+#include "PositionSolver.h"
+#include "../core/Config.h"
+#include <cmath>
+
+void PositionSolver::predict(BallStore& balls, const float* stepScale, float gravity, float deltaTime,
+                             JobSystem* jobs) {
+    const size_t count = balls.size();
+    startX.resize(count);
+    startY.resize(count);
+    startVx.resize(count);
+    startVy.resize(count);
+    stepTime.resize(count);
+    ballContacts.clear();
+    wallContacts.clear();
+
+    auto predictRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float h = stepScale ? deltaTime * stepScale[i] : deltaTime;
+            stepTime[i] = h;
+            startX[i] = balls.x[i];
+            startY[i] = balls.y[i];
+            balls.vy[i] += gravity * h;
+            startVx[i] = balls.vx[i];
+            startVy[i] = balls.vy[i];
+            balls.x[i] += balls.vx[i] * h;
+            balls.y[i] += balls.vy[i] * h;
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, predictRange);
+    } else {
+        predictRange(0, count);
+    }
+}
+
+void PositionSolver::addBallPair(const BallStore& balls, uint32_t a, uint32_t b) {
+    if (inverseMass(balls, a) + inverseMass(balls, b) <= 0.0f) {
+        return;
+    }
+
+    float dx = balls.x[b] - balls.x[a];
+    float dy = balls.y[b] - balls.y[a];
+    float reach = (balls.radius[a] + balls.radius[b]) * (1.0f + Config::XPBD_CONTACT_MARGIN);
+    if (dx * dx + dy * dy >= reach * reach) {
+        return;
+    }
+    ballContacts.push_back(BallContact{a, b, 1.0f, 0.0f, 0.0f});
+}
+
+void PositionSolver::addWallContacts(const BallStore& balls, const ContainerKernel::Params& params) {
+    wallCenterX = params.centerX;
+    wallCenterY = params.centerY;
+    wallRadius = params.radius;
+
+    const size_t count = balls.size();
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t ball = static_cast<uint32_t>(i);
+        if (inverseMass(balls, ball) <= 0.0f) {
+            continue;
+        }
+
+        // The side of the shell is where the ball started, so a ball
+        // predicted straight through the wall is still held by it
+        float startDx = startX[i] - params.centerX;
+        float startDy = startY[i] - params.centerY;
+        bool inside = startDx * startDx + startDy * startDy <= params.radius * params.radius;
+
+        float dx = balls.x[i] - params.centerX;
+        float dy = balls.y[i] - params.centerY;
+        float distanceSquared = dx * dx + dy * dy;
+        float margin = balls.radius[i] * Config::XPBD_CONTACT_MARGIN;
+        if (inside) {
+            float near = params.radius - balls.radius[i] - margin;
+            if (near > 0.0f && distanceSquared < near * near) {
+                continue;
+            }
+        } else {
+            float near = params.radius + balls.radius[i] + margin;
+            if (distanceSquared > near * near) {
+                continue;
+            }
+        }
+        if (ContainerKernel::isInGap(dx, dy, params)) {
+            continue;
+        }
+        wallContacts.push_back(WallContact{ball, inside, 1.0f, 0.0f, 0.0f});
+    }
+}
+
+void PositionSolver::solve(BallStore& balls, float deltaTime, float restitution, int iterations) {
+    const float compliance = Config::XPBD_COMPLIANCE / (deltaTime * deltaTime);
+    for (int k = 0; k < iterations; ++k) {
+        projectBallContacts(balls, compliance);
+        projectWallContacts(balls, compliance);
+    }
+    deriveVelocities(balls);
+    applyRestitution(balls, restitution);
+}
+
+void PositionSolver::projectBallContacts(BallStore& balls, float compliance) {
+    for (BallContact& c : ballContacts) {
+        float dx = balls.x[c.b] - balls.x[c.a];
+        float dy = balls.y[c.b] - balls.y[c.a];
+        float distanceSquared = dx * dx + dy * dy;
+        float reach = balls.radius[c.a] + balls.radius[c.b];
+        if (distanceSquared >= reach * reach) {
+            continue;
+        }
+
+        // Coincident centers: push apart along x, like CollisionDetector
+        float distance = std::sqrt(distanceSquared);
+        if (distance > 0.0f) {
+            c.normalX = dx / distance;
+            c.normalY = dy / distance;
+        } else {
+            c.normalX = 1.0f;
+            c.normalY = 0.0f;
+        }
+
+        // C = distance - reach < 0; a moves along -n, b along +n
+        float wA = inverseMass(balls, c.a);
+        float wB = inverseMass(balls, c.b);
+        float constraint = distance - reach;
+        float deltaLambda = (-constraint - compliance * c.lambda) / (wA + wB + compliance);
+        c.lambda += deltaLambda;
+        balls.x[c.a] -= c.normalX * wA * deltaLambda;
+        balls.y[c.a] -= c.normalY * wA * deltaLambda;
+        balls.x[c.b] += c.normalX * wB * deltaLambda;
+        balls.y[c.b] += c.normalY * wB * deltaLambda;
+    }
+}
+
+void PositionSolver::projectWallContacts(BallStore& balls, float compliance) {
+    for (WallContact& c : wallContacts) {
+        float dx = balls.x[c.ball] - wallCenterX;
+        float dy = balls.y[c.ball] - wallCenterY;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance <= 0.0f) {
+            continue;
+        }
+
+        // Inside: distance <= R - r; outside: distance >= R + r
+        float r = balls.radius[c.ball];
+        float constraint = c.inside ? (wallRadius - r) - distance : distance - (wallRadius + r);
+        if (constraint >= 0.0f) {
+            continue;
+        }
+        float sign = c.inside ? 1.0f : -1.0f;
+        c.normalX = sign * dx / distance;
+        c.normalY = sign * dy / distance;
+
+        float w = inverseMass(balls, c.ball);
+        float deltaLambda = (-constraint - compliance * c.lambda) / (w + compliance);
+        c.lambda += deltaLambda;
+        balls.x[c.ball] -= c.normalX * w * deltaLambda;
+        balls.y[c.ball] -= c.normalY * w * deltaLambda;
+    }
+}
+
+void PositionSolver::deriveVelocities(BallStore& balls) {
+    // Balls that did not step keep their velocity
+    const size_t count = balls.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (stepTime[i] > 0.0f) {
+            float inverseTime = 1.0f / stepTime[i];
+            balls.vx[i] = (balls.x[i] - startX[i]) * inverseTime;
+            balls.vy[i] = (balls.y[i] - startY[i]) * inverseTime;
+        }
+    }
+}
+
+void PositionSolver::applyRestitution(BallStore& balls, float restitution) {
+    // Contacts that pushed this step: the normal velocity becomes
+    // -restitution times the approach speed before projection (zero for
+    // slow approaches), replacing whatever the projection produced
+    for (const BallContact& c : ballContacts) {
+        if (c.lambda <= 0.0f) {
+            continue;
+        }
+        float approachBefore = (startVx[c.a] - startVx[c.b]) * c.normalX + (startVy[c.a] - startVy[c.b]) * c.normalY;
+        float approach = (balls.vx[c.a] - balls.vx[c.b]) * c.normalX + (balls.vy[c.a] - balls.vy[c.b]) * c.normalY;
+        float target = approachBefore > Config::SOLVER_RESTITUTION_THRESHOLD ? -restitution * approachBefore : 0.0f;
+
+        float wA = inverseMass(balls, c.a);
+        float wB = inverseMass(balls, c.b);
+        float excess = (approach - target) / (wA + wB);
+        balls.vx[c.a] -= c.normalX * excess * wA;
+        balls.vy[c.a] -= c.normalY * excess * wA;
+        balls.vx[c.b] += c.normalX * excess * wB;
+        balls.vy[c.b] += c.normalY * excess * wB;
+    }
+
+    for (const WallContact& c : wallContacts) {
+        if (c.lambda <= 0.0f) {
+            continue;
+        }
+        float approachBefore = startVx[c.ball] * c.normalX + startVy[c.ball] * c.normalY;
+        float approach = balls.vx[c.ball] * c.normalX + balls.vy[c.ball] * c.normalY;
+        float target = approachBefore > Config::SOLVER_RESTITUTION_THRESHOLD ? -restitution * approachBefore : 0.0f;
+        balls.vx[c.ball] -= c.normalX * (approach - target);
+        balls.vy[c.ball] -= c.normalY * (approach - target);
+    }
+}
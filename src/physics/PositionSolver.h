@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include "ContainerKernel.h"
+#include <cstdint>
+#include <vector>
+
+// Position-based (XPBD) contact solver.
+// predict() integrates gravity and moves every ball to its predicted
+// position, remembering where it started. Candidate ball pairs and wall
+// contacts near the predicted positions are then gathered, and solve()
+// projects the non-penetration constraints (ball-ball distance at least
+// r1 + r2; wall distance on the side of the shell the ball started on) for
+// a fixed number of Gauss-Seidel iterations, with accumulated multipliers
+// and XPBD_COMPLIANCE as in XPBD. Velocities are derived from the
+// position change, and a final velocity pass over the touching contacts
+// sets their normal velocity to -restitution times the approach speed
+// before the step (zero for approaches slower than
+// SOLVER_RESTITUTION_THRESHOLD), the same bounce rule as ContactSolver.
+//
+// Projection never adds kinetic energy the way a stiff penalty or impulse
+// correction of a deep overlap can, so piles stay stable at large steps.
+//
+// Balls with a zero step scale (sleeping, or waiting out a multi-rate
+// block) take part with infinite mass.
+class PositionSolver {
+public:
+    // Apply gravity and move to the predicted positions. stepScale (or
+    // nullptr) scales each ball's step as in IntegrationKernel.
+    void predict(BallStore& balls, const float* stepScale, float gravity, float deltaTime, JobSystem* jobs);
+
+    // Add a pair if it is within XPBD_CONTACT_MARGIN of touching
+    void addBallPair(const BallStore& balls, uint32_t a, uint32_t b);
+
+    // Add wall constraints for balls near the shell outside the gap
+    void addWallContacts(const BallStore& balls, const ContainerKernel::Params& params);
+
+    // Project, derive velocities and apply restitution
+    void solve(BallStore& balls, float deltaTime, float restitution, int iterations);
+
+    size_t getContactCount() const { return ballContacts.size() + wallContacts.size(); }
+
+private:
+    struct BallContact {
+        uint32_t a, b;
+        float normalX, normalY;  // From a towards b, updated by every projection
+        float lambda;            // Accumulated multiplier
+    };
+
+    struct WallContact {
+        uint32_t ball;
+        bool inside;             // Started inside the shell: stay within R - r
+        float normalX, normalY;  // From the ball into the wall
+        float lambda;
+    };
+
+    std::vector<BallContact> ballContacts;
+    std::vector<WallContact> wallContacts;
+    std::vector<float> startX, startY;   // Positions before prediction
+    std::vector<float> startVx, startVy; // Velocities after gravity, before projection
+    std::vector<float> stepTime;         // deltaTime * step scale per ball
+    float wallCenterX, wallCenterY, wallRadius;
+
+    float inverseMass(const BallStore& balls, uint32_t ball) const {
+        return stepTime[ball] > 0.0f ? balls.invMass[ball] : 0.0f;
+    }
+    void projectBallContacts(BallStore& balls, float compliance);
+    void projectWallContacts(BallStore& balls, float compliance);
+    void deriveVelocities(BallStore& balls);
+    void applyRestitution(BallStore& balls, float restitution);
+};
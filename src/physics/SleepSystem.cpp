@@ -0,0 +1,239 @@
+#include "SleepSystem.h"
+#include "../math/MathUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+SleepSystem::SleepSystem()
+    : enabled(false)
+    , sleepingCount(0)
+    , nextIsland(1)
+    , stepsSinceCheck(0)
+    , hasScene(false)
+    , sceneGravity(0.0f)
+    , sceneRadius(0.0f)
+    , sceneGapAngle(0.0f)
+    , sceneRotationSpeed(0.0f)
+{
+}
+
+void SleepSystem::beginStep(BallStore& balls, const Container& container, float gravity) {
+    // Sleepers rest against the gravity and walls they fell asleep in; any
+    // change to those can leave them floating or overlapping
+    bool sceneChanged = hasScene &&
+        (gravity != sceneGravity || container.getRadius() != sceneRadius ||
+         container.getGapAngleDegrees() != sceneGapAngle ||
+         container.getRotationSpeed() != sceneRotationSpeed);
+    if (sleepingCount > 0 && (!enabled || sceneChanged)) {
+        wakeAll(balls);
+    }
+
+    hasScene = true;
+    sceneGravity = gravity;
+    sceneRadius = container.getRadius();
+    sceneGapAngle = container.getGapAngleDegrees();
+    sceneRotationSpeed = container.getRotationSpeed();
+
+    if (enabled) {
+        wakeRequest.assign(balls.size(), 0);
+    }
+}
+
+void SleepSystem::wakeAll(BallStore& balls) {
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (balls.island[i] != 0) {
+            balls.island[i] = 0;
+            balls.stepScale[i] = 1.0f;
+            balls.restSteps[i] = 0;
+        }
+    }
+    sleepingCount = 0;
+}
+
+void SleepSystem::wakeDisturbedIslands(BallStore& balls, const Container& container) {
+    if (sleepingCount == 0) {
+        return;
+    }
+
+    // Islands that were hit, or whose wall balls the gap is turning towards
+    wakeIslands.clear();
+    const size_t count = balls.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (balls.island[i] != 0 && (wakeRequest[i] || isNearGap(balls, i, container))) {
+            wakeIslands.push_back(balls.island[i]);
+        }
+    }
+
+    // Recount as well: culling may have removed sleeping balls
+    std::sort(wakeIslands.begin(), wakeIslands.end());
+    wakeIslands.erase(std::unique(wakeIslands.begin(), wakeIslands.end()), wakeIslands.end());
+    sleepingCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t island = balls.island[i];
+        if (island == 0) {
+            continue;
+        }
+        if (!wakeIslands.empty() && std::binary_search(wakeIslands.begin(), wakeIslands.end(), island)) {
+            balls.island[i] = 0;
+            balls.stepScale[i] = 1.0f;
+            balls.restSteps[i] = 0;
+        } else {
+            ++sleepingCount;
+        }
+    }
+}
+
+size_t SleepSystem::updateRestCounters(BallStore& balls, float deltaTime, JobSystem* jobs) {
+    // Net drift from the anchor rather than the instantaneous speed: balls in
+    // a pile jitter back and forth every step while staying in place
+    const float drift = Config::SLEEP_SPEED * Config::SLEEP_STEPS * deltaTime;
+    const float limit = drift * drift;
+    std::atomic<size_t> restingCount(0);
+
+    auto update = [&](size_t begin, size_t end) {
+        size_t resting = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (balls.island[i] != 0) {
+                continue;
+            }
+            float dx = balls.x[i] - balls.restX[i];
+            float dy = balls.y[i] - balls.restY[i];
+            uint16_t steps = balls.restSteps[i];
+            if (steps == 0 || dx * dx + dy * dy > limit) {
+                balls.restX[i] = balls.x[i];
+                balls.restY[i] = balls.y[i];
+                steps = 1;
+            } else if (steps < Config::SLEEP_STEPS) {
+                ++steps;
+            }
+            balls.restSteps[i] = steps;
+            resting += steps >= Config::SLEEP_STEPS ? 1 : 0;
+        }
+        restingCount.fetch_add(resting, std::memory_order_relaxed);
+    };
+
+    if (jobs) {
+        jobs->parallelFor(balls.size(), Config::PARALLEL_GRAIN_SIZE, update);
+    } else {
+        update(0, balls.size());
+    }
+    return restingCount.load(std::memory_order_relaxed);
+}
+
+void SleepSystem::beginIslandSearch(const BallStore& balls) {
+    const size_t count = balls.size();
+    parent.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        parent[i] = static_cast<uint32_t>(i);
+    }
+    blockedBalls.clear();
+}
+
+void SleepSystem::linkPair(const BallStore& balls, uint32_t a, uint32_t b) {
+    // Sleeping balls keep restSteps at SLEEP_STEPS, so this covers them too
+    const bool restingA = balls.restSteps[a] >= Config::SLEEP_STEPS;
+    const bool restingB = balls.restSteps[b] >= Config::SLEEP_STEPS;
+    if (!restingA && !restingB) {
+        return;
+    }
+
+    float dx = balls.x[b] - balls.x[a];
+    float dy = balls.y[b] - balls.y[a];
+    float reach = (balls.radius[a] + balls.radius[b]) * (1.0f + Config::SLEEP_CONTACT_SLOP);
+    if (dx * dx + dy * dy >= reach * reach) {
+        return;
+    }
+
+    if (!restingA) {
+        blockedBalls.push_back(b);
+    } else if (!restingB) {
+        blockedBalls.push_back(a);
+    } else {
+        uint32_t rootA = findRoot(a);
+        uint32_t rootB = findRoot(b);
+        if (rootA != rootB) {
+            parent[rootA] = rootB;
+        }
+    }
+}
+
+void SleepSystem::finishIslandSearch(BallStore& balls, const Container& container) {
+    const size_t count = balls.size();
+    rootBlocked.assign(count, 0);
+    rootIsland.assign(count, 0);
+
+    for (uint32_t ball : blockedBalls) {
+        rootBlocked[findRoot(ball)] = 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (balls.island[i] == 0 && balls.restSteps[i] >= Config::SLEEP_STEPS && isNearGap(balls, i, container)) {
+            rootBlocked[findRoot(static_cast<uint32_t>(i))] = 1;
+        }
+    }
+
+    // A new island id for every unblocked island with a resting awake ball;
+    // sleeping islands merged into it adopt the id, untouched ones keep theirs
+    for (size_t i = 0; i < count; ++i) {
+        if (balls.island[i] != 0 || balls.restSteps[i] < Config::SLEEP_STEPS) {
+            continue;
+        }
+        uint32_t root = findRoot(static_cast<uint32_t>(i));
+        if (!rootBlocked[root] && rootIsland[root] == 0) {
+            rootIsland[root] = nextIsland;
+            nextIsland = nextIsland == 0xFFFFFFFFu ? 1 : nextIsland + 1;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (balls.restSteps[i] < Config::SLEEP_STEPS) {
+            continue;
+        }
+        uint32_t island = rootIsland[findRoot(static_cast<uint32_t>(i))];
+        if (island == 0) {
+            continue;
+        }
+        if (balls.island[i] == 0) {
+            ++sleepingCount;
+        }
+        balls.island[i] = island;
+        balls.stepScale[i] = 0.0f;
+        balls.vx[i] = 0.0f;
+        balls.vy[i] = 0.0f;
+    }
+}
+
+uint32_t SleepSystem::findRoot(uint32_t ball) {
+    // Path halving
+    while (parent[ball] != ball) {
+        parent[ball] = parent[parent[ball]];
+        ball = parent[ball];
+    }
+    return ball;
+}
+
+bool SleepSystem::isNearGap(const BallStore& balls, size_t ball, const Container& container) const {
+    float gapAngle = container.getGapAngleDegrees();
+    if (gapAngle <= 0.0001f) {
+        return false;
+    }
+
+    // Only balls in the wall band can lose their support to the gap
+    Vector2D center = container.getCenter();
+    float dx = balls.x[ball] - center.x;
+    float dy = balls.y[ball] - center.y;
+    float band = balls.radius[ball] * (1.0f + Config::SLEEP_CONTACT_SLOP);
+    float inner = std::max(container.getRadius() - band, 0.0f);
+    float outer = container.getRadius() + band;
+    float distanceSquared = dx * dx + dy * dy;
+    if (distanceSquared < inner * inner || distanceSquared > outer * outer) {
+        return false;
+    }
+
+    if (gapAngle + 2.0f * Config::SLEEP_GAP_MARGIN >= 360.0f) {
+        return true;
+    }
+    float margin = MathUtils::degToRad(Config::SLEEP_GAP_MARGIN);
+    return MathUtils::isAngleInRange(std::atan2(dy, dx),
+                                     container.getGapStartAngle() - margin,
+                                     container.getGapEndAngle() + margin);
+}
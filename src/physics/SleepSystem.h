@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../entities/Container.h"
+#include "../core/JobSystem.h"
+#include "../core/Config.h"
+#include <cstdint>
+#include <vector>
+
+// Puts resting balls to sleep in contact islands.
+// A ball counts as resting once it has stayed for SLEEP_STEPS steps within
+// the distance it would cover at SLEEP_SPEED of where the count started.
+// Every SLEEP_CHECK_INTERVAL steps the touching pairs of the current
+// broadphase are merged into islands (union-find); an island
+// with no contact to a moving ball and no ball next to the gap goes to sleep
+// as a whole. Sleeping balls have zero velocity and a zero step scale, so
+// integration leaves them in place, and pairs of sleeping balls are skipped
+// by the narrowphase. An awake ball that hits a sleeper slowly bounces off
+// it as if it were static; a harder hit wakes the sleeper's island.
+// Islands also wake when the gap rotates towards one of their wall balls,
+// and everything wakes when gravity or the container shape changes.
+//
+// The state lives in the BallStore sleep columns, so it follows culling and
+// permutes with the rows.
+class SleepSystem {
+public:
+    SleepSystem();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    // Before integration: wake everything if the scene changed under the
+    // sleeping balls (or sleep was turned off), and reset wake requests
+    void beginStep(BallStore& balls, const Container& container, float gravity);
+
+    // Narrowphase hook: a hit hard enough to wake this sleeping ball's island.
+    // Only touches the ball's own row, like the collision response.
+    void requestWake(uint32_t ball) { wakeRequest[ball] = 1; }
+
+    // After collisions: wake disturbed islands, update the resting counters
+    // and, when due, put resting islands found through the broadphase to sleep
+    template <typename Broadphase>
+    void endStep(BallStore& balls, const Container& container, const Broadphase& broadphase,
+                 float deltaTime, JobSystem* jobs);
+
+    size_t getSleepingCount() const { return sleepingCount; }
+
+private:
+    bool enabled;
+    size_t sleepingCount;
+    uint32_t nextIsland;
+    int stepsSinceCheck;
+
+    // Scene state the sleeping balls were resting in
+    bool hasScene;
+    float sceneGravity;
+    float sceneRadius;
+    float sceneGapAngle;
+    float sceneRotationSpeed;
+
+    std::vector<uint8_t> wakeRequest;    // Per ball, set by the narrowphase
+    std::vector<uint32_t> wakeIslands;   // Sorted island ids to wake
+
+    // Island search scratch
+    std::vector<uint32_t> parent;        // Union-find forest over ball indices
+    std::vector<uint32_t> blockedBalls;  // Resting balls touching a moving one
+    std::vector<uint8_t> rootBlocked;
+    std::vector<uint32_t> rootIsland;    // New island id per root (0 = none)
+
+    void wakeAll(BallStore& balls);
+    void wakeDisturbedIslands(BallStore& balls, const Container& container);
+    size_t updateRestCounters(BallStore& balls, float deltaTime, JobSystem* jobs);
+    void beginIslandSearch(const BallStore& balls);
+    void linkPair(const BallStore& balls, uint32_t a, uint32_t b);
+    void finishIslandSearch(BallStore& balls, const Container& container);
+    uint32_t findRoot(uint32_t ball);
+    bool isNearGap(const BallStore& balls, size_t ball, const Container& container) const;
+};
+
+template <typename Broadphase>
+void SleepSystem::endStep(BallStore& balls, const Container& container, const Broadphase& broadphase,
+                          float deltaTime, JobSystem* jobs) {
+    if (!enabled) {
+        return;
+    }
+
+    wakeDisturbedIslands(balls, container);
+    size_t restingCount = updateRestCounters(balls, deltaTime, jobs);
+
+    if (++stepsSinceCheck < Config::SLEEP_CHECK_INTERVAL || restingCount == 0) {
+        return;
+    }
+    stepsSinceCheck = 0;
+
+    beginIslandSearch(balls);
+    broadphase.forEachPotentialCollision([&](uint32_t a, uint32_t b) {
+        linkPair(balls, a, b);
+    });
+    finishIslandSearch(balls, container);
+}
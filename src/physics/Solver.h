@@ -0,0 +1,9 @@
+#pragma once
+
+// How ball-ball and ball-wall contacts are resolved each step. Picked at
+// startup (see SimulationOptions) or with PhysicsEngine::setSolver.
+enum class SolverType {
+    Pairwise,          // CollisionResolver: each touching pair once, in pair order, with positional separation
+    SequentialImpulse, // ContactSolver: iterated impulses over all contacts, warm started, split-impulse correction
+    PositionBased      // PositionSolver: XPBD projection of predicted positions, velocities derived afterwards
+};
@@ -1,78 +1,169 @@
 #include "SpatialGrid.h"
+#include "../core/Config.h"
 #include <algorithm>
 #include <cmath>
 
+namespace {
+    // Interleave the low 16 bits of x and y into a Z-order code
+    inline uint32_t mortonCode(uint32_t x, uint32_t y) {
+        auto spread = [](uint32_t v) {
+            v &= 0x0000FFFFu;
+            v = (v | (v << 8)) & 0x00FF00FFu;
+            v = (v | (v << 4)) & 0x0F0F0F0Fu;
+            v = (v | (v << 2)) & 0x33333333u;
+            v = (v | (v << 1)) & 0x55555555u;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+}
+
 SpatialGrid::SpatialGrid(float cellSize, float worldWidth, float worldHeight)
-    : cellSize(cellSize)
+    : originX(0.0f)
+    , originY(0.0f)
+    , worldWidth(0.0f)
+    , worldHeight(0.0f)
+    , cellSize(0.0f)
+    , invCellSize(0.0f)
+    , gridWidth(0)
+    , gridHeight(0)
+    , mortonOrder(false)
 {
-    gridWidth = static_cast<int>(std::ceil(worldWidth / cellSize));
-    gridHeight = static_cast<int>(std::ceil(worldHeight / cellSize));
-    cells.resize(gridWidth * gridHeight);
+    configure(0.0f, 0.0f, worldWidth, worldHeight, cellSize);
 }
 
-void SpatialGrid::clear() {
-    for (auto& cell : cells) {
-        cell.clear();
+void SpatialGrid::configure(float newOriginX, float newOriginY, float newWorldWidth, float newWorldHeight, float newCellSize) {
+    if (newOriginX == originX && newOriginY == originY &&
+        newWorldWidth == worldWidth && newWorldHeight == worldHeight &&
+        newCellSize == cellSize) {
+        return;
     }
-}
 
-void SpatialGrid::insertBall(size_t ballIndex, const Vector2D& position) {
-    int cx = getCellX(position.x);
-    int cy = getCellY(position.y);
+    originX = newOriginX;
+    originY = newOriginY;
+    worldWidth = newWorldWidth;
+    worldHeight = newWorldHeight;
+    cellSize = newCellSize;
+    invCellSize = 1.0f / newCellSize;
 
-    if (cx >= 0 && cx < gridWidth && cy >= 0 && cy < gridHeight) {
-        cells[getCellIndex(cx, cy)].push_back(ballIndex);
+    gridWidth = std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)));
+    gridHeight = std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)));
+    cellStart.resize(gridWidth * gridHeight + 1);
+    updateCellOrder();
+}
+
+void SpatialGrid::setMortonOrder(bool enabled) {
+    if (enabled == mortonOrder) {
+        return;
     }
+    mortonOrder = enabled;
+    updateCellOrder();
 }
 
-void SpatialGrid::getPotentialCollisions(
-    const std::vector<Ball>&,
-    std::vector<std::pair<size_t, size_t>>& outPairs)
-{
-    outPairs.clear();
-
-    // Check each cell and its neighbors
-    for (int cy = 0; cy < gridHeight; ++cy) {
-        for (int cx = 0; cx < gridWidth; ++cx) {
-            const auto& cell = cells[getCellIndex(cx, cy)];
-
-            // Check within same cell
-            for (size_t i = 0; i < cell.size(); ++i) {
-                for (size_t j = i + 1; j < cell.size(); ++j) {
-                    outPairs.emplace_back(cell[i], cell[j]);
-                }
-            }
+void SpatialGrid::updateCellOrder() {
+    if (!mortonOrder) {
+        cellRank.clear();
+        rankCell.clear();
+        return;
+    }
+
+    // Rank cells by Z-order code; only redone when the layout changes
+    const uint32_t cellCount = static_cast<uint32_t>(gridWidth) * gridHeight;
+    rankCell.resize(cellCount);
+    for (uint32_t cell = 0; cell < cellCount; ++cell) {
+        rankCell[cell] = cell;
+    }
+    const uint32_t width = static_cast<uint32_t>(gridWidth);
+    std::sort(rankCell.begin(), rankCell.end(), [width](uint32_t a, uint32_t b) {
+        return mortonCode(a % width, a / width) < mortonCode(b % width, b / width);
+    });
+
+    cellRank.resize(cellCount);
+    for (uint32_t rank = 0; rank < cellCount; ++rank) {
+        cellRank[rankCell[rank]] = rank;
+    }
+}
 
-            // Check with adjacent cells (right, down, down-right, down-left)
-            const int dx[] = {1, 0, 1, -1};
-            const int dy[] = {0, 1, 1, 1};
+void SpatialGrid::markBallsSorted() {
+    // Ball k is now the k-th ball in cell order
+    const size_t cellCount = static_cast<size_t>(gridWidth) * gridHeight;
+    for (size_t c = 0; c < cellCount; ++c) {
+        for (uint32_t k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+            cellBalls[k] = k;
+            ballCell[k] = static_cast<uint32_t>(c);
+        }
+    }
+}
 
-            for (int d = 0; d < 4; ++d) {
-                int nx = cx + dx[d];
-                int ny = cy + dy[d];
+void SpatialGrid::build(const BallStore& balls, JobSystem* jobs) {
+    const size_t count = balls.size();
+    const size_t cellCount = static_cast<size_t>(gridWidth) * gridHeight;
+    ballCell.resize(count);
+    cellBalls.resize(count);
 
-                if (nx >= 0 && nx < gridWidth && ny >= 0 && ny < gridHeight) {
-                    const auto& neighborCell = cells[getCellIndex(nx, ny)];
+    // Contiguous blocks of balls, each with its own row of cell counters
+    size_t blockCount = 1;
+    if (jobs) {
+        size_t maxBlocks = std::max<size_t>(1, count / Config::PARALLEL_GRAIN_SIZE);
+        blockCount = std::min<size_t>(jobs->getThreadCount(), maxBlocks);
+    }
+    const size_t blockSize = (count + blockCount - 1) / std::max<size_t>(blockCount, 1);
+    blockCursor.resize(blockCount * cellCount);
+    std::fill(blockCursor.begin(), blockCursor.end(), 0u);
 
-                    for (size_t i : cell) {
-                        for (size_t j : neighborCell) {
-                            outPairs.emplace_back(i, j);
-                        }
-                    }
-                }
+    auto forEachBlock = [&](auto&& blockFn) {
+        auto runBlocks = [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; ++block) {
+                blockFn(block, block * blockSize, std::min(count, (block + 1) * blockSize));
             }
+        };
+        if (jobs) {
+            jobs->parallelFor(blockCount, 1, runBlocks);
+        } else {
+            runBlocks(0, blockCount);
+        }
+    };
+
+    // Pass 1: assign cells and count balls per cell
+    forEachBlock([&](size_t block, size_t begin, size_t end) {
+        uint32_t* counts = blockCursor.data() + block * cellCount;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t cell = static_cast<uint32_t>(getCellIndex(getCellX(balls.x[i]), getCellY(balls.y[i])));
+            ballCell[i] = cell;
+            ++counts[cell];
+        }
+    });
+
+    // Prefix sum over (cell, block): counts -> cell start offsets, and each
+    // block's counter becomes its write cursor inside the cell range
+    uint32_t offset = 0;
+    for (size_t c = 0; c < cellCount; ++c) {
+        cellStart[c] = offset;
+        for (size_t block = 0; block < blockCount; ++block) {
+            uint32_t& slot = blockCursor[block * cellCount + c];
+            uint32_t blockBalls = slot;
+            slot = offset;
+            offset += blockBalls;
         }
     }
+    cellStart[cellCount] = offset;
+
+    // Pass 2: scatter ball indices into their cell ranges
+    forEachBlock([&](size_t block, size_t begin, size_t end) {
+        uint32_t* cursors = blockCursor.data() + block * cellCount;
+        for (size_t i = begin; i < end; ++i) {
+            cellBalls[cursors[ballCell[i]]++] = static_cast<uint32_t>(i);
+        }
+    });
 }
 
 int SpatialGrid::getCellX(float x) const {
-    return static_cast<int>(x / cellSize);
+    // Clamp in float space so far-away positions cannot overflow the cast
+    float cx = std::floor((x - originX) * invCellSize);
+    return static_cast<int>(std::min(std::max(cx, 0.0f), static_cast<float>(gridWidth - 1)));
 }
 
 int SpatialGrid::getCellY(float y) const {
-    return static_cast<int>(y / cellSize);
-}
-
-int SpatialGrid::getCellIndex(int cx, int cy) const {
-    return cy * gridWidth + cx;
+    float cy = std::floor((y - originY) * invCellSize);
+    return static_cast<int>(std::min(std::max(cy, 0.0f), static_cast<float>(gridHeight - 1)));
 }
@@ -1,31 +1,159 @@
 #pragma once
 
-#include "../entities/Ball.h"
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
 
+// Uniform grid stored as a flat counting-sort layout:
+// the balls of cell c are cellBalls[cellStart[c] .. cellStart[c + 1]).
+// All arrays are reused between rebuilds, so a steady-state rebuild does
+// not allocate.
+//
+// Balls outside the grid extents are clamped into the border cells rather
+// than dropped. Clamping never moves two balls further than one cell apart,
+// so no contact is missed.
+//
+// Cells are stored in row-major order by default. In Morton order they are
+// stored (and walked) along a Z-order curve instead, so cells that are close
+// in 2D are also close in cellBalls; permuting the BallStore by
+// getBallsByCell() then gives the balls the same locality.
 class SpatialGrid {
 public:
     SpatialGrid(float cellSize, float worldWidth, float worldHeight);
 
-    // Clear and rebuild grid
-    void clear();
-    void insertBall(size_t ballIndex, const Vector2D& position);
+    // Re-layout the grid to cover [originX, originX + worldWidth) x
+    // [originY, originY + worldHeight) with the given cell size.
+    // Does nothing if the layout is unchanged.
+    void configure(float originX, float originY, float worldWidth, float worldHeight, float cellSize);
 
-    // Get potential collision pairs
-    void getPotentialCollisions(
-        const std::vector<Ball>& balls,
-        std::vector<std::pair<size_t, size_t>>& outPairs
-    );
+    // Rebuild the grid from ball positions (two-pass counting sort).
+    // With a job system the balls are split into contiguous blocks that
+    // count and scatter in parallel; the result is identical to a serial build.
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Store and walk cells in Morton (Z-order) instead of row-major order.
+    // Takes effect on the next build.
+    void setMortonOrder(bool enabled);
+    bool isMortonOrder() const { return mortonOrder; }
+
+    // Ball indices sorted by cell, as of the last build
+    const std::vector<uint32_t>& getBallsByCell() const { return cellBalls; }
+
+    // Call after the BallStore was permuted into getBallsByCell() order:
+    // renumbers the built grid to match without rebuilding it
+    void markBallsSorted();
+
+    // Call visit(a, b) for every potential collision pair, walking the cells
+    // in storage (row-major or Morton) order. Pairs are handed straight to
+    // the visitor and never stored, so the narrowphase check inlines into
+    // the cell walk.
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+    // Visit the candidate pairs owned by cell (cx, cy): pairs inside the cell
+    // and with its right, down, down-right and down-left neighbours. The
+    // visit only touches balls in columns cx-1..cx+1 and rows cy..cy+1.
+    template <typename Visitor>
+    void visitCellPairs(int cx, int cy, Visitor&& visit) const;
+
+    // Call visit(index) for every ball in the 3 x 3 cells around (x, y)
+    template <typename Visitor>
+    void forEachNearby(float x, float y, Visitor&& visit) const;
+
+    float getCellSize() const { return cellSize; }
+    int getGridWidth() const { return gridWidth; }
+    int getGridHeight() const { return gridHeight; }
 
 private:
+    float originX, originY;
+    float worldWidth, worldHeight;
     float cellSize;
+    float invCellSize;
     int gridWidth, gridHeight;
+    bool mortonOrder;
+
+    std::vector<uint32_t> cellRank;  // Row-major cell -> storage slot (Morton order only)
+    std::vector<uint32_t> rankCell;  // Storage slot -> row-major cell (Morton order only)
 
-    // Grid cells store ball indices
-    std::vector<std::vector<size_t>> cells;
+    std::vector<uint32_t> cellStart;    // gridWidth * gridHeight + 1 offsets
+    std::vector<uint32_t> blockCursor;  // Per-block counts, then scatter cursors (scratch)
+    std::vector<uint32_t> cellBalls;    // Ball indices sorted by cell
+    std::vector<uint32_t> ballCell;    // Cell of each ball
 
     int getCellX(float x) const;
     int getCellY(float y) const;
-    int getCellIndex(int cx, int cy) const;
+    int getCellIndex(int cx, int cy) const {
+        int cell = cy * gridWidth + cx;
+        return mortonOrder ? static_cast<int>(cellRank[cell]) : cell;
+    }
+    void updateCellOrder();
 };
+
+template <typename Visitor>
+void SpatialGrid::forEachPotentialCollision(Visitor&& visit) const {
+    if (mortonOrder) {
+        for (uint32_t cell : rankCell) {
+            visitCellPairs(static_cast<int>(cell) % gridWidth, static_cast<int>(cell) / gridWidth, visit);
+        }
+        return;
+    }
+
+    for (int cy = 0; cy < gridHeight; ++cy) {
+        for (int cx = 0; cx < gridWidth; ++cx) {
+            visitCellPairs(cx, cy, visit);
+        }
+    }
+}
+
+template <typename Visitor>
+void SpatialGrid::visitCellPairs(int cx, int cy, Visitor&& visit) const {
+    const int cell = getCellIndex(cx, cy);
+    const uint32_t begin = cellStart[cell];
+    const uint32_t end = cellStart[cell + 1];
+    if (begin == end) {
+        return;
+    }
+
+    // Within the same cell
+    for (uint32_t i = begin; i < end; ++i) {
+        for (uint32_t j = i + 1; j < end; ++j) {
+            visit(cellBalls[i], cellBalls[j]);
+        }
+    }
+
+    // Adjacent cells (right, down, down-right, down-left)
+    const int dx[] = {1, 0, 1, -1};
+    const int dy[] = {0, 1, 1, 1};
+    for (int d = 0; d < 4; ++d) {
+        int nx = cx + dx[d];
+        int ny = cy + dy[d];
+        if (nx < 0 || nx >= gridWidth || ny >= gridHeight) {
+            continue;
+        }
+
+        const int neighbor = getCellIndex(nx, ny);
+        const uint32_t neighborBegin = cellStart[neighbor];
+        const uint32_t neighborEnd = cellStart[neighbor + 1];
+        for (uint32_t i = begin; i < end; ++i) {
+            for (uint32_t j = neighborBegin; j < neighborEnd; ++j) {
+                visit(cellBalls[i], cellBalls[j]);
+            }
+        }
+    }
+}
+
+template <typename Visitor>
+void SpatialGrid::forEachNearby(float x, float y, Visitor&& visit) const {
+    const int cx = getCellX(x);
+    const int cy = getCellY(y);
+    for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, gridHeight - 1); ++ny) {
+        for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, gridWidth - 1); ++nx) {
+            const int cell = getCellIndex(nx, ny);
+            for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                visit(cellBalls[k]);
+            }
+        }
+    }
+}
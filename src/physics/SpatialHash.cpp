@@ -0,0 +1,120 @@
+#include "SpatialHash.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr size_t MIN_SLOTS = 1024;
+    constexpr float COORDINATE_LIMIT = 1073741824.0f;  // 2^30: neighbours of any cell still fit in int32
+}
+
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize(0.0f)
+    , invCellSize(0.0f)
+    , generation(1)
+    , slotMask(0)
+{
+    setMinCellSize(cellSize);
+    growTable(MIN_SLOTS);
+}
+
+void SpatialHash::setMinCellSize(float minCellSize) {
+    // Power-of-two sizes make the reciprocal exact, and re-tune only when
+    // the required size crosses a power of two
+    float size = std::exp2(std::ceil(std::log2(std::max(minCellSize, 1e-3f))));
+    cellSize = size;
+    invCellSize = 1.0f / size;
+}
+
+int32_t SpatialHash::toCell(float coordinate) const {
+    // Clamp in float space so far-away positions cannot overflow the cast
+    float c = std::floor(coordinate * invCellSize);
+    return static_cast<int32_t>(std::min(std::max(c, -COORDINATE_LIMIT), COORDINATE_LIMIT));
+}
+
+void SpatialHash::build(const BallStore& balls, JobSystem* jobs) {
+    const size_t count = balls.size();
+    ballKey.resize(count);
+    ballCell.resize(count);
+    cellBalls.resize(count);
+
+    // Keep the load factor at or below one half even if every ball is in
+    // its own cell
+    if (count * 2 > slotKey.size()) {
+        growTable(count * 2);
+    }
+
+    // Invalidate last build's slots
+    if (++generation == 0) {
+        std::fill(slotGeneration.begin(), slotGeneration.end(), 0u);
+        generation = 1;
+    }
+    cellX.clear();
+    cellY.clear();
+
+    // Cell coordinates are independent per ball
+    auto computeKeys = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ballKey[i] = packKey(toCell(balls.x[i]), toCell(balls.y[i]));
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, computeKeys);
+    } else {
+        computeKeys(0, count);
+    }
+
+    // Give occupied cells dense ids and count their balls
+    cellStart.clear();
+    cellStart.push_back(0);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t cell = insertCell(ballKey[i]);
+        ballCell[i] = cell;
+        ++cellStart[cell + 1];
+    }
+
+    // Prefix sum, then scatter with cellStart as cursors and shift back
+    const size_t cellCount = cellX.size();
+    for (size_t c = 0; c < cellCount; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        cellBalls[cellStart[ballCell[i]]++] = static_cast<uint32_t>(i);
+    }
+    for (size_t c = cellCount; c > 0; --c) {
+        cellStart[c] = cellStart[c - 1];
+    }
+    cellStart[0] = 0;
+}
+
+uint32_t SpatialHash::insertCell(uint64_t key) {
+    uint32_t slot = slotFor(key);
+    while (slotGeneration[slot] == generation) {
+        if (slotKey[slot] == key) {
+            return slotCell[slot];
+        }
+        slot = (slot + 1) & slotMask;
+    }
+
+    // First ball in this cell
+    const uint32_t cell = static_cast<uint32_t>(cellX.size());
+    slotGeneration[slot] = generation;
+    slotKey[slot] = key;
+    slotCell[slot] = cell;
+    cellX.push_back(static_cast<int32_t>(key >> 32));
+    cellY.push_back(static_cast<int32_t>(static_cast<uint32_t>(key)));
+    cellStart.push_back(0);
+    return cell;
+}
+
+void SpatialHash::growTable(size_t minSlots) {
+    // Only called between builds, so nothing live needs rehashing
+    size_t slots = MIN_SLOTS;
+    while (slots < minSlots) {
+        slots *= 2;
+    }
+    slotKey.assign(slots, 0);
+    slotCell.assign(slots, 0);
+    slotGeneration.assign(slots, 0);
+    slotMask = static_cast<uint32_t>(slots - 1);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
+#include <vector>
+
+// Unbounded uniform grid stored as a hash of occupied cells.
+// Cells are power-of-two sized and keyed by their integer coordinates in an
+// open-addressing (linear probing) table, so any world extent works and
+// memory grows with the number of occupied cells rather than the area.
+// Occupied cells get dense ids in first-seen order and the balls are then
+// counting-sorted by dense id, the same flat layout SpatialGrid uses.
+//
+// Table slots are invalidated by bumping a generation counter instead of
+// clearing, and every array is reused, so a steady-state rebuild neither
+// clears nor allocates.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize);
+
+    // Use the smallest power-of-two cell size that is at least minCellSize
+    void setMinCellSize(float minCellSize);
+    float getCellSize() const { return cellSize; }
+
+    // Rebuild from ball positions
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every potential collision pair
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+    size_t getOccupiedCellCount() const { return cellX.size(); }
+
+private:
+    static constexpr uint32_t NO_CELL = 0xFFFFFFFFu;
+
+    float cellSize;
+    float invCellSize;
+
+    // Open-addressing table: slot -> (key, dense cell id), live if
+    // slotGeneration matches the current build
+    std::vector<uint64_t> slotKey;
+    std::vector<uint32_t> slotCell;
+    std::vector<uint32_t> slotGeneration;
+    uint32_t generation;
+    uint32_t slotMask;
+
+    // Dense occupied cells
+    std::vector<int32_t> cellX, cellY;
+    std::vector<uint32_t> cellStart;  // occupied cells + 1 offsets
+    std::vector<uint32_t> cellBalls;  // Ball indices sorted by dense cell
+    std::vector<uint32_t> ballCell;   // Dense cell of each ball
+    std::vector<uint64_t> ballKey;    // Packed cell coordinates of each ball (scratch)
+
+    static uint64_t packKey(int32_t cx, int32_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+    uint32_t slotFor(uint64_t key) const {
+        // Fibonacci hashing spreads neighbouring coordinates across the table
+        return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & slotMask;
+    }
+
+    uint32_t insertCell(uint64_t key);
+    uint32_t findCell(int32_t cx, int32_t cy) const;  // NO_CELL if empty
+    void growTable(size_t minSlots);
+    int32_t toCell(float coordinate) const;
+};
+
+inline uint32_t SpatialHash::findCell(int32_t cx, int32_t cy) const {
+    const uint64_t key = packKey(cx, cy);
+    for (uint32_t slot = slotFor(key);; slot = (slot + 1) & slotMask) {
+        if (slotGeneration[slot] != generation) {
+            return NO_CELL;
+        }
+        if (slotKey[slot] == key) {
+            return slotCell[slot];
+        }
+    }
+}
+
+template <typename Visitor>
+void SpatialHash::forEachPotentialCollision(Visitor&& visit) const {
+    const uint32_t cellCount = static_cast<uint32_t>(cellX.size());
+    for (uint32_t cell = 0; cell < cellCount; ++cell) {
+        const uint32_t begin = cellStart[cell];
+        const uint32_t end = cellStart[cell + 1];
+
+        // Within the same cell
+        for (uint32_t i = begin; i < end; ++i) {
+            for (uint32_t j = i + 1; j < end; ++j) {
+                visit(cellBalls[i], cellBalls[j]);
+            }
+        }
+
+        // Occupied neighbours (right, down, down-right, down-left)
+        const int32_t dx[] = {1, 0, 1, -1};
+        const int32_t dy[] = {0, 1, 1, 1};
+        for (int d = 0; d < 4; ++d) {
+            const uint32_t neighbor = findCell(cellX[cell] + dx[d], cellY[cell] + dy[d]);
+            if (neighbor == NO_CELL) {
+                continue;
+            }
+
+            const uint32_t neighborBegin = cellStart[neighbor];
+            const uint32_t neighborEnd = cellStart[neighbor + 1];
+            for (uint32_t i = begin; i < end; ++i) {
+                for (uint32_t j = neighborBegin; j < neighborEnd; ++j) {
+                    visit(cellBalls[i], cellBalls[j]);
+                }
+            }
+        }
+    }
+}
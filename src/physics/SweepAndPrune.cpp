@@ -0,0 +1,78 @@
+#include "SweepAndPrune.h"
+#include "../core/Config.h"
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune()
+    : layoutVersion(0)
+    , knownCount(0)
+{
+}
+
+void SweepAndPrune::build(const BallStore& balls, JobSystem* jobs) {
+    // Follow removals/spawns; a missed re-layout resets to index order
+    bool coherent = balls.syncIndexList(order, layoutVersion, knownCount);
+
+    const size_t count = order.size();
+    minX.resize(count);
+    maxX.resize(count);
+    minY.resize(count);
+    maxY.resize(count);
+
+    auto gather = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            uint32_t i = order[k];
+            float r = balls.radius[i];
+            minX[k] = balls.x[i] - r;
+            maxX[k] = balls.x[i] + r;
+            minY[k] = balls.y[i] - r;
+            maxY[k] = balls.y[i] + r;
+        }
+    };
+
+    if (!coherent) {
+        // No usable previous order: full sort once
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return balls.x[a] - balls.radius[a] < balls.x[b] - balls.radius[b];
+        });
+    }
+
+    if (jobs) {
+        jobs->parallelFor(count, Config::PARALLEL_GRAIN_SIZE, gather);
+    } else {
+        gather(0, count);
+    }
+
+    insertionSort();
+}
+
+void SweepAndPrune::insertionSort() {
+    // Sort all gathered columns by minX; nearly sorted input makes this ~O(n)
+    const size_t count = order.size();
+    for (size_t i = 1; i < count; ++i) {
+        float key = minX[i];
+        if (minX[i - 1] <= key) {
+            continue;
+        }
+
+        uint32_t ball = order[i];
+        float right = maxX[i];
+        float top = minY[i];
+        float bottom = maxY[i];
+
+        size_t j = i;
+        while (j > 0 && minX[j - 1] > key) {
+            order[j] = order[j - 1];
+            minX[j] = minX[j - 1];
+            maxX[j] = maxX[j - 1];
+            minY[j] = minY[j - 1];
+            maxY[j] = maxY[j - 1];
+            --j;
+        }
+
+        order[j] = ball;
+        minX[j] = key;
+        maxX[j] = right;
+        minY[j] = top;
+        maxY[j] = bottom;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../entities/BallStore.h"
+#include "../core/JobSystem.h"
+#include <cstdint>
+#include <vector>
+
+// Sort-and-sweep broadphase along the x axis.
+// The ball order is kept sorted by left edge between steps and re-sorted
+// with insertion sort, which is close to linear because balls barely move
+// per step. Removals and spawns are folded in through the BallStore layout
+// remap, so the previous order is kept across culling.
+class SweepAndPrune {
+public:
+    SweepAndPrune();
+
+    // Re-sort the x order and gather the sorted bounds for the sweep
+    void build(const BallStore& balls, JobSystem* jobs = nullptr);
+
+    // Call visit(a, b) for every pair whose bounding boxes overlap
+    template <typename Visitor>
+    void forEachPotentialCollision(Visitor&& visit) const;
+
+private:
+    std::vector<uint32_t> order;  // Ball indices sorted by left edge (persistent)
+    uint64_t layoutVersion;       // BallStore layout the order refers to
+    size_t knownCount;            // Rows of that layout already in the order
+
+    // Bounds in sorted order (gathered each step for a linear sweep)
+    std::vector<float> minX, maxX, minY, maxY;
+
+    void insertionSort();
+};
+
+template <typename Visitor>
+void SweepAndPrune::forEachPotentialCollision(Visitor&& visit) const {
+    const size_t count = order.size();
+    for (size_t i = 0; i < count; ++i) {
+        const float right = maxX[i];
+        const float top = minY[i];
+        const float bottom = maxY[i];
+
+        // Every later box starts further right; stop at the first one that
+        // starts past this box's right edge
+        for (size_t j = i + 1; j < count && minX[j] <= right; ++j) {
+            if (minY[j] <= bottom && maxY[j] >= top) {
+                visit(order[i], order[j]);
+            }
+        }
+    }
+}
@@ -0,0 +1,357 @@
+// Headless checks for the physics kernels, the parallel narrowphase and
+// deterministic mode.
+// Each check prints one line and the program exits non-zero if any fails,
+// so it runs under ctest (BUILD_TESTS).
+//
+// Usage: BallBouncingTests
+
+#define SDL_MAIN_HANDLED
+#include "../core/Config.h"
+#include "../core/JobSystem.h"
+#include "../entities/BallStore.h"
+#include "../entities/Container.h"
+#include "../math/MathUtils.h"
+#include "../math/StateHash.h"
+#include "../physics/IntegrationKernel.h"
+#include "../physics/PhysicsEngine.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr unsigned TEST_SEED = 12345;
+    constexpr float TEST_TIMESTEP = 1.0f / 120.0f;
+
+    // Narrowphase scenes
+    constexpr float SCENE_SIZE = 1024.0f;
+    constexpr float SCENE_BALL_RADIUS = 5.0f;
+    constexpr int SCENE_STEPS = 5;
+    constexpr int PILE_STEPS = 30;
+    constexpr float PILE_SPACING = 1.9f * SCENE_BALL_RADIUS;  // Overlapping neighbours
+    constexpr unsigned PARALLEL_THREADS = 4;
+    const unsigned DETERMINISM_THREADS[] = {1, 2, 4};  // Oversubscribed on small hosts, on purpose
+    constexpr float NARROWPHASE_TOLERANCE = 1e-3f;  // Relative to the value, or absolute below 1
+
+    // Counts that are not a multiple of any lane width, so every SIMD loop
+    // ends in a scalar tail (and 1 has no SIMD part at all)
+    const size_t ODD_COUNTS[] = {1, 3, 5, 7, 9, 13, 17, 31, 33, 1001};
+
+    float randomFloat(float low, float high) {
+        return low + (high - low) * (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX));
+    }
+
+    struct Columns {
+        std::vector<float> x, y, vx, vy, scale;
+
+        explicit Columns(size_t count) : x(count), y(count), vx(count), vy(count), scale(count) {
+            for (size_t i = 0; i < count; ++i) {
+                x[i] = randomFloat(0.0f, 1024.0f);
+                y[i] = randomFloat(0.0f, 768.0f);
+                vx[i] = randomFloat(-400.0f, 400.0f);
+                vy[i] = randomFloat(-400.0f, 400.0f);
+                // Frozen, partial and full steps, as multi-rate and sleep use them
+                int kind = std::rand() % 3;
+                scale[i] = kind == 0 ? 0.0f : kind == 1 ? randomFloat(0.0f, 4.0f) : 1.0f;
+            }
+        }
+
+        size_t size() const { return x.size(); }
+    };
+
+    // Bitwise, like the kernels promise
+    bool sameColumns(const Columns& a, const Columns& b) {
+        const size_t bytes = a.size() * sizeof(float);
+        return std::memcmp(a.x.data(), b.x.data(), bytes) == 0
+            && std::memcmp(a.y.data(), b.y.data(), bytes) == 0
+            && std::memcmp(a.vy.data(), b.vy.data(), bytes) == 0;
+    }
+
+    bool report(const char* name, size_t count, float gravity, bool passed) {
+        std::printf("%-44s count=%-5zu gravity=%-6.1f %s\n", name, count, gravity, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    // integrate() against integrateScalar()
+    bool checkIntegrate(size_t count, float gravity) {
+        Columns simd(count);
+        Columns scalar = simd;
+        IntegrationKernel::integrate(simd.x.data(), simd.y.data(), simd.vx.data(), simd.vy.data(),
+                                     count, gravity, TEST_TIMESTEP);
+        IntegrationKernel::integrateScalar(scalar.x.data(), scalar.y.data(), scalar.vx.data(), scalar.vy.data(),
+                                           count, gravity, TEST_TIMESTEP);
+        return report("integrate vs integrateScalar", count, gravity, sameColumns(simd, scalar));
+    }
+
+    // integrateScaled() against integrateScalar() one ball at a time with
+    // its own step length
+    bool checkIntegrateScaled(size_t count, float gravity) {
+        Columns simd(count);
+        Columns scalar = simd;
+        IntegrationKernel::integrateScaled(simd.x.data(), simd.y.data(), simd.vx.data(), simd.vy.data(),
+                                           simd.scale.data(), count, gravity, TEST_TIMESTEP);
+        for (size_t i = 0; i < count; ++i) {
+            IntegrationKernel::integrateScalar(&scalar.x[i], &scalar.y[i], &scalar.vx[i], &scalar.vy[i],
+                                               1, gravity, TEST_TIMESTEP * scalar.scale[i]);
+        }
+        return report("integrateScaled vs integrateScalar", count, gravity, sameColumns(simd, scalar));
+    }
+
+    // Every select() kernel against itself run one ball at a time, which
+    // only takes the scalar tail
+    bool checkSelect(IntegratorType type, const char* name, size_t count, float gravity, bool scaled) {
+        IntegrationKernel::Function kernel = IntegrationKernel::select(type, gravity == 0.0f, scaled);
+        Columns simd(count);
+        Columns scalar = simd;
+        kernel(simd.x.data(), simd.y.data(), simd.vx.data(), simd.vy.data(), simd.scale.data(),
+               count, gravity, TEST_TIMESTEP);
+        for (size_t i = 0; i < count; ++i) {
+            kernel(&scalar.x[i], &scalar.y[i], &scalar.vx[i], &scalar.vy[i], &scalar.scale[i],
+                   1, gravity, TEST_TIMESTEP);
+        }
+        char label[64];
+        std::snprintf(label, sizeof(label), "select %s%s vs scalar", name, scaled ? " scaled" : "");
+        return report(label, count, gravity, sameColumns(simd, scalar));
+    }
+
+    bool checkIntegrationKernels() {
+        std::printf("Integration kernels: %s\n", IntegrationKernel::getInstructionSet());
+
+        struct Named {
+            IntegratorType type;
+            const char* name;
+        };
+        const Named integrators[] = {
+            {IntegratorType::SemiImplicitEuler, "euler"},
+            {IntegratorType::VelocityVerlet, "velocity-verlet"},
+            {IntegratorType::PositionVerlet, "position-verlet"},
+        };
+
+        bool passed = true;
+        for (float gravity : {981.0f, 0.0f}) {
+            for (size_t count : ODD_COUNTS) {
+                passed &= checkIntegrate(count, gravity);
+                passed &= checkIntegrateScaled(count, gravity);
+                for (const Named& integrator : integrators) {
+                    passed &= checkSelect(integrator.type, integrator.name, count, gravity, false);
+                    passed &= checkSelect(integrator.type, integrator.name, count, gravity, true);
+                }
+            }
+        }
+        return passed;
+    }
+
+    Container sceneContainer() {
+        return Container(Vector2D(SCENE_SIZE * 0.5f, SCENE_SIZE * 0.5f), SCENE_SIZE * 0.45f, 0.0f);
+    }
+
+    // Pairs of overlapping balls, far enough apart that no ball touches
+    // more than its partner during the run: the result does not depend on
+    // the order pairs are resolved in, so the serial and parallel paths
+    // must agree
+    BallStore buildPairScene() {
+        const float spacing = 8.0f * SCENE_BALL_RADIUS;
+        const Container container = sceneContainer();
+        const float maxDistance = container.getRadius() - spacing;
+        const Vector2D center = container.getCenter();
+        const SDL_Color color{255, 255, 255, 255};
+
+        BallStore balls;
+        for (float y = center.y - maxDistance; y <= center.y + maxDistance; y += spacing) {
+            for (float x = center.x - maxDistance; x <= center.x + maxDistance; x += spacing) {
+                Vector2D middle(x + randomFloat(-1.0f, 1.0f), y + randomFloat(-1.0f, 1.0f));
+                if (middle.distance(center) > maxDistance) {
+                    continue;
+                }
+                Vector2D axis = Vector2D::fromAngle(randomFloat(0.0f, MathUtils::TWO_PI), 0.98f * SCENE_BALL_RADIUS);
+                Vector2D closing = axis * randomFloat(0.0f, 10.0f);
+                Vector2D drift = Vector2D::fromAngle(randomFloat(0.0f, MathUtils::TWO_PI), randomFloat(0.0f, 50.0f));
+                balls.push(Ball(middle - axis, drift + closing, SCENE_BALL_RADIUS, color));
+                balls.push(Ball(middle + axis, drift - closing, SCENE_BALL_RADIUS, color));
+            }
+        }
+        return balls;
+    }
+
+    // A disk of overlapping balls on a jittered lattice: most balls touch
+    // several neighbours, many of them across cell borders, so the result
+    // depends on the order pairs are resolved in
+    BallStore buildPileScene() {
+        const Container container = sceneContainer();
+        const float maxDistance = 0.6f * container.getRadius();
+        const Vector2D center = container.getCenter();
+        const SDL_Color color{255, 255, 255, 255};
+
+        BallStore balls;
+        for (float y = center.y - maxDistance; y <= center.y + maxDistance; y += PILE_SPACING) {
+            for (float x = center.x - maxDistance; x <= center.x + maxDistance; x += PILE_SPACING) {
+                Vector2D position(x + randomFloat(-0.5f, 0.5f), y + randomFloat(-0.5f, 0.5f));
+                if (position.distance(center) > maxDistance) {
+                    continue;
+                }
+                Vector2D velocity = Vector2D::fromAngle(randomFloat(0.0f, MathUtils::TWO_PI), randomFloat(0.0f, 200.0f));
+                balls.push(Ball(position, velocity, SCENE_BALL_RADIUS, color));
+            }
+        }
+        return balls;
+    }
+
+    // Runs the scene through the uniform grid. Without a job system and
+    // outside deterministic mode that is the row-major cell walk; otherwise
+    // the 3 x 2 checkerboard, threaded if jobs has more than one thread.
+    BallStore runNarrowphase(const BallStore& scene, JobSystem* jobs, bool deterministic, int steps,
+                             BroadphaseType broadphase = BroadphaseType::UniformGrid,
+                             SolverType solver = SolverType::Pairwise, bool sleep = false) {
+        PhysicsEngine physics(Config::GRAVITY, SCENE_SIZE, SCENE_SIZE);
+        physics.setJobSystem(jobs);
+        physics.setBroadphase(broadphase);
+        physics.setSolver(solver);
+        physics.setSleepEnabled(sleep);
+        physics.setDeterministic(deterministic);
+
+        BallStore balls = scene;
+        Container container = sceneContainer();
+        for (int s = 0; s < steps; ++s) {
+            container.update(TEST_TIMESTEP);
+            physics.update(balls, container, TEST_TIMESTEP, Config::RESTITUTION);
+        }
+        return balls;
+    }
+
+    bool closeTo(float a, float b) {
+        return std::fabs(a - b) <= NARROWPHASE_TOLERANCE * std::max({1.0f, std::fabs(a), std::fabs(b)});
+    }
+
+    // Positions and velocities by ball id (reordering may permute rows)
+    bool sameBalls(const BallStore& a, const BallStore& b, float& worst) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        std::vector<uint32_t> rowA(a.size()), rowB(b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            rowA[i] = static_cast<uint32_t>(i);
+            rowB[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(rowA.begin(), rowA.end(), [&](uint32_t l, uint32_t r) { return a.id[l] < a.id[r]; });
+        std::sort(rowB.begin(), rowB.end(), [&](uint32_t l, uint32_t r) { return b.id[l] < b.id[r]; });
+
+        bool same = true;
+        worst = 0.0f;
+        for (size_t k = 0; k < a.size(); ++k) {
+            const uint32_t i = rowA[k];
+            const uint32_t j = rowB[k];
+            if (a.id[i] != b.id[j]) {
+                return false;
+            }
+            const float pairs[4][2] = {{a.x[i], b.x[j]}, {a.y[i], b.y[j]}, {a.vx[i], b.vx[j]}, {a.vy[i], b.vy[j]}};
+            for (const auto& pair : pairs) {
+                worst = std::max(worst, std::fabs(pair[0] - pair[1]));
+                same &= closeTo(pair[0], pair[1]);
+            }
+        }
+        return same;
+    }
+
+    // Dense pile: the checkerboard run on worker threads against the same
+    // checkerboard run in order on the calling thread, bitwise. A phase
+    // whose cells share a ball races and breaks the match.
+    bool checkCheckerboardThreads() {
+        const BallStore scene = buildPileScene();
+        JobSystem jobs(PARALLEL_THREADS);
+
+        uint64_t serial = runNarrowphase(scene, nullptr, true, PILE_STEPS).hashState(StateHash::SEED);
+        uint64_t threaded = runNarrowphase(scene, &jobs, true, PILE_STEPS).hashState(StateHash::SEED);
+
+        bool passed = serial == threaded;
+        std::printf("%-44s balls=%-5zu threads=%u %016" PRIx64 " %016" PRIx64 " %s\n", "threaded vs in-order checkerboard",
+                    scene.size(), PARALLEL_THREADS, serial, threaded, passed ? "ok" : "FAILED");
+        return passed;
+    }
+
+    // Isolated pairs: the threaded checkerboard against the row-major cell
+    // walk, within a tolerance. Only a missed or doubled pair can differ.
+    bool checkCheckerboardPairs() {
+        const BallStore scene = buildPairScene();
+        JobSystem jobs(PARALLEL_THREADS);
+
+        BallStore serial = runNarrowphase(scene, nullptr, false, SCENE_STEPS);
+        BallStore parallel = runNarrowphase(scene, &jobs, false, SCENE_STEPS);
+
+        float worst = 0.0f;
+        bool passed = sameBalls(serial, parallel, worst);
+        std::printf("%-44s balls=%-5zu threads=%u max difference=%g %s\n", "threaded checkerboard vs cell walk",
+                    scene.size(), PARALLEL_THREADS, worst, passed ? "ok" : "FAILED");
+        return passed;
+    }
+}
+
+namespace {
+    // Deterministic mode: the dense pile hashes bitwise equal at every
+    // thread count, for every broadphase, solver and sleep setting
+    bool checkDeterministicThreads() {
+        const BallStore scene = buildPileScene();
+        struct NamedBroadphase {
+            BroadphaseType type;
+            const char* name;
+        };
+        const NamedBroadphase broadphases[] = {
+            {BroadphaseType::UniformGrid, "grid"},
+            {BroadphaseType::SweepAndPrune, "sap"},
+            {BroadphaseType::AabbTree, "tree"},
+            {BroadphaseType::HierarchicalGrid, "hgrid"},
+            {BroadphaseType::SpatialHash, "hash"},
+            {BroadphaseType::NeighborList, "verlet"},
+            {BroadphaseType::IncrementalGrid, "igrid"},
+        };
+        struct NamedSolver {
+            SolverType type;
+            const char* name;
+        };
+        const NamedSolver solvers[] = {
+            {SolverType::Pairwise, "pairwise"},
+            {SolverType::SequentialImpulse, "impulse"},
+            {SolverType::PositionBased, "xpbd"},
+        };
+
+        JobSystem jobs(1);
+        bool passed = true;
+        for (const NamedBroadphase& broadphase : broadphases) {
+            for (const NamedSolver& solver : solvers) {
+                for (bool sleep : {false, true}) {
+                    uint64_t reference = 0;
+                    bool reproduced = true;
+                    for (unsigned threads : DETERMINISM_THREADS) {
+                        jobs.setThreadCount(threads);
+                        uint64_t hash = runNarrowphase(scene, &jobs, true, PILE_STEPS, broadphase.type, solver.type, sleep)
+                                            .hashState(StateHash::SEED);
+                        if (threads == DETERMINISM_THREADS[0]) {
+                            reference = hash;
+                        }
+                        reproduced = reproduced && hash == reference;
+                    }
+                    char label[64];
+                    std::snprintf(label, sizeof(label), "deterministic %s %s%s", broadphase.name, solver.name,
+                                  sleep ? " sleep" : "");
+                    std::printf("%-44s threads=1,2,4 %016" PRIx64 " %s\n", label, reference, reproduced ? "ok" : "FAILED");
+                    passed = passed && reproduced;
+                }
+            }
+        }
+        return passed;
+    }
+}
+
+int main() {
+    std::srand(TEST_SEED);
+
+    bool passed = checkIntegrationKernels();
+    passed &= checkCheckerboardThreads();
+    passed &= checkCheckerboardPairs();
+    passed &= checkDeterministicThreads();
+
+    std::printf("%s\n", passed ? "All checks passed" : "Some checks FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}